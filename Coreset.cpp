@@ -0,0 +1,250 @@
+/*
+ * Coreset.cpp
+ */
+
+#include "Coreset.hpp"
+
+#include <cfloat>
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+#include "InstanceSet.hpp"
+#include "ResultsSet.hpp"
+#include "Instance.hpp"
+#include "Tree.hpp"
+#include "Node.hpp"
+#include "Parameters.hpp"
+#include "SplitKernel.hpp"
+
+using namespace std;
+
+Coreset::Coreset( const InstanceSet *_iset, const ResultsSet *_rset, int size ) :
+    iset_(_iset),
+    rset_(_rset)
+{
+    const size_t nFeatures = iset_->features().size();
+
+    // first strata: instances with the same best algorithm
+    map< int, vector< int > > byAlg;
+    for ( int i=0 ; (i<iset_->size()) ; ++i )
+        byAlg[rset_->algsetting_rank( i, 0 )].push_back( i );
+    for ( auto &ba : byAlg )
+        groups_.push_back( ba.second );
+
+    // largest strata are split first
+    priority_queue< pair< size_t, int > > queue;
+    for ( size_t s=0 ; (s<groups_.size()) ; ++s )
+        queue.push( make_pair( groups_[s].size(), (int)s ) );
+
+    while ((int)groups_.size()<size && queue.size() && queue.top().first>1)
+    {
+        const int s = queue.top().second;
+        queue.pop();
+
+        // feature with the largest range of ranks
+        int bestF = -1;
+        double bestSpread = 0.0;
+        for ( size_t f=0 ; (f<nFeatures) ; ++f )
+        {
+            double minR = DBL_MAX, maxR = -DBL_MAX;
+            for ( auto i : groups_[s] )
+            {
+                minR = std::min( minR, iset_->norm_feature_val_rank( i, f ) );
+                maxR = std::max( maxR, iset_->norm_feature_val_rank( i, f ) );
+            }
+            if (maxR-minR>bestSpread)
+            {
+                bestSpread = maxR-minR;
+                bestF = f;
+            }
+        }
+        // all instances of the stratum have the same ranks
+        if (bestF<0)
+            continue;
+
+        vector< double > ranks;
+        for ( auto i : groups_[s] )
+            ranks.push_back( iset_->norm_feature_val_rank( i, bestF ) );
+        std::nth_element( ranks.begin(), ranks.begin()+ranks.size()/2, ranks.end() );
+        const double med = ranks[ranks.size()/2];
+        // if the median is the largest value, it goes to the right
+        const double maxR = *max_element( ranks.begin(), ranks.end() );
+
+        vector< int > left, right;
+        for ( auto i : groups_[s] )
+        {
+            const double r = iset_->norm_feature_val_rank( i, bestF );
+            if ( r<med || (r==med && med<maxR) )
+                left.push_back( i );
+            else
+                right.push_back( i );
+        }
+        assert( left.size() && right.size() );
+
+        groups_[s].swap( left );
+        groups_.push_back( right );
+        queue.push( make_pair( groups_[s].size(), s ) );
+        queue.push( make_pair( groups_.back().size(), (int)groups_.size()-1 ) );
+    }
+
+    // representative: instance closest to the average ranks
+    for ( auto &g : groups_ )
+    {
+        vector< double > avg( nFeatures, 0.0 );
+        for ( auto i : g )
+            for ( size_t f=0 ; (f<nFeatures) ; ++f )
+                avg[f] += iset_->norm_feature_val_rank( i, f ) / ((double)g.size());
+
+        size_t bestPos = 0;
+        double bestDist = DBL_MAX;
+        for ( size_t p=0 ; (p<g.size()) ; ++p )
+        {
+            double dist = 0.0;
+            for ( size_t f=0 ; (f<nFeatures) ; ++f )
+            {
+                const double df = iset_->norm_feature_val_rank( g[p], f ) - avg[f];
+                dist += df*df;
+            }
+            if (dist<bestDist)
+            {
+                bestDist = dist;
+                bestPos = p;
+            }
+        }
+        std::swap( g[0], g[bestPos] );
+    }
+
+    cout << "coreset with " << groups_.size() << " representatives of " << iset_->size() <<
+        " instances, " << byAlg.size() << " best algorithms" << endl;
+}
+
+Tree *Coreset::refine( const Tree *tree ) const
+{
+    Tree *res = new Tree( iset_, rset_ );
+    Node *root = res->create_root();
+    refineNode( res, tree->root(), root );
+    res->computeCost();
+
+    return res;
+}
+
+void Coreset::refineNode( Tree *res, const Node *orig, Node *node ) const
+{
+    if (orig->isLeaf())
+        return;
+
+    double value = 0.0;
+    if (!bestThreshold( orig, node, &value ))
+        return;
+
+    node->branchOnVal( orig->branchFeature(), value );
+    res->addNode( node->child()[0] );
+    res->addNode( node->child()[1] );
+    refineNode( res, orig->ichild(0), node->child()[0] );
+    refineNode( res, orig->ichild(1), node->child()[1] );
+}
+
+bool Coreset::bestThreshold( const Node *orig, const Node *node, double *value ) const
+{
+    const size_t idxF = orig->branchFeature();
+    const size_t nAlgs = rset_->algsettings().size();
+    const int minEl = Parameters::minElementsBranch;
+
+    // leafs of the left and right subtrees, which are kept fixed
+    vector< const Node * > leafs, queue;
+    queue.push_back( orig->ichild(0) );
+    queue.push_back( orig->ichild(1) );
+    while (queue.size())
+    {
+        const Node *n = queue.back();
+        queue.pop_back();
+        if (n->isLeaf())
+            leafs.push_back( n );
+        else
+        {
+            queue.push_back( n->ichild(0) );
+            queue.push_back( n->ichild(1) );
+        }
+    }
+    unordered_map< const Node *, int > leafIdx;
+    for ( size_t l=0 ; (l<leafs.size()) ; ++l )
+        leafIdx[leafs[l]] = l;
+
+    auto leafOf = [&] ( const Node *n, int i ) {
+        while (!n->isLeaf())
+            n = (iset_->instance(i).float_feature(n->branchFeature())<=n->branchValue()) ? n->ichild(0) : n->ichild(1);
+        return leafIdx[n];
+    };
+
+    vector< char > inNode( iset_->size(), 0 );
+    for ( size_t i=0 ; (i<node->n_elements()) ; ++i )
+        inNode[node->elements()[i]] = 1;
+    vector< int > ord;
+    for ( auto i : iset_->instancesByFeatureVal( idxF ) )
+        if (inNode[i])
+            ord.push_back( i );
+    const int m = (int)ord.size();
+
+    // all instances start in the right side
+    vector< int > leafL( m ), leafR( m );
+    vector< double > sums( leafs.size()*nAlgs, 0.0 );
+    for ( int k=0 ; (k<m) ; ++k )
+    {
+        leafL[k] = leafOf( orig->ichild(0), ord[k] );
+        leafR[k] = leafOf( orig->ichild(1), ord[k] );
+        split_kernel_add( &sums[leafR[k]*nAlgs], rset_->resInst(ord[k]), nAlgs );
+    }
+    auto leafMin = [&] ( int l ) {
+        return *min_element( sums.begin()+l*nAlgs, sums.begin()+(l+1)*nAlgs );
+    };
+    vector< double > mins( leafs.size() );
+    double total = 0.0;
+    for ( size_t l=0 ; (l<leafs.size()) ; ++l )
+    {
+        mins[l] = leafMin( l );
+        total += mins[l];
+    }
+
+    // all thresholds are evaluated, representatives may change
+    // sides when this decreases the cost in all instances
+    const double origValue = orig->branchValue();
+
+    bool found = false;
+    double bestCost = DBL_MAX;
+    for ( int k=0 ; (k<m-1) ; ++k )
+    {
+        // moves ord[k] to the left side
+        const int lL = leafL[k], lR = leafR[k];
+        total -= mins[lL] + mins[lR];
+        split_kernel_sub( &sums[lR*nAlgs], rset_->resInst(ord[k]), nAlgs );
+        split_kernel_add( &sums[lL*nAlgs], rset_->resInst(ord[k]), nAlgs );
+        mins[lL] = leafMin( lL );
+        mins[lR] = leafMin( lR );
+        total += mins[lL] + mins[lR];
+
+        const double v = iset_->instance(ord[k]).float_feature(idxF);
+        const double vNext = iset_->instance(ord[k+1]).float_feature(idxF);
+        if (vNext<=v || k+1<minEl || m-k-1<minEl)
+            continue;
+
+        // on ties the partition of the original threshold is kept
+        const bool isOrig = (v<=origValue && vNext>origValue);
+        if ( total<bestCost-1e-9 || (isOrig && total<=bestCost+1e-9) )
+        {
+            bestCost = total;
+            *value = v;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+Coreset::~Coreset ()
+{
+}
@@ -0,0 +1,55 @@
+/*
+ * Coreset.hpp
+ */
+
+#ifndef CORESET_HPP_
+#define CORESET_HPP_
+
+class InstanceSet;
+class ResultsSet;
+class Tree;
+class Node;
+
+#include <vector>
+
+// weighted subsample of the instances: instances are stratified by
+// their best algorithm and then by feature rank cells, splitting the
+// largest stratum at the median rank of its most spread feature. each
+// stratum is one group, represented by the instance closest to its
+// average ranks and weighted by its number of instances
+class Coreset
+{
+public:
+    Coreset( const InstanceSet *_iset, const ResultsSet *_rset, int size );
+
+    // groups of the coreset, the first instance of each group
+    // is its representative
+    const std::vector< std::vector< int > > &groups() const {
+        return groups_;
+    }
+
+    // tree with the structure and features of tree but with thresholds
+    // refined considering all instances: the threshold of each node is
+    // the cheapest one, evaluated with the subtrees below it fixed. it
+    // is not limited to the interval between the representatives on
+    // both sides of the original threshold: representatives change
+    // sides when this decreases the cost in all instances, on ties the
+    // partition of the original threshold is kept
+    Tree *refine( const Tree *tree ) const;
+
+    virtual ~Coreset ();
+private:
+    const InstanceSet *iset_;
+    const ResultsSet *rset_;
+
+    std::vector< std::vector< int > > groups_;
+
+    void refineNode( Tree *res, const Node *orig, Node *node ) const;
+
+    // best threshold for the elements of node on the feature of orig,
+    // returns false if no threshold gives children with at least
+    // minElementsBranch instances
+    bool bestThreshold( const Node *orig, const Node *node, double *value ) const;
+};
+
+#endif /* CORESET_HPP_ */
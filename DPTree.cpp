@@ -0,0 +1,589 @@
+/*
+ * DPTree.cpp
+ */
+
+#include <vector>
+#include <cassert>
+#include <cfloat>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <omp.h>
+
+#include "DPTree.hpp"
+#include "InstanceSet.hpp"
+#include "ResultsSet.hpp"
+#include "Tree.hpp"
+#include "Node.hpp"
+#include "Parameters.hpp"
+#include "SubSetResults.hpp"
+#include "SplitKernel.hpp"
+
+using namespace std;
+
+DPTree::DPTree( const InstanceSet *_iset, const ResultsSet *_rset ) :
+    iset_(_iset),
+    rset_(_rset),
+    nInsts(_iset->size()),
+    nFeatures(_iset->features().size()),
+    nAlgs(_rset->algsettings().size()),
+    nLevels(std::max( ((int)Parameters::maxDepth)-1, 0 )),
+    fval(new double[_iset->size()*_iset->features().size()]),
+    res(nullptr),
+    minInst(new double[_iset->size()]),
+    ownData(true),
+    upperBound(DBL_MAX),
+    memo(nLevels+1),
+    side(nLevels+1, vector< char >(_iset->size(), 0)),
+    sumL(nLevels+1, vector< double >(_rset->algsettings().size())),
+    sumR(nLevels+1, vector< double >(_rset->algsettings().size())),
+    sumD1(_rset->algsettings().size()),
+    startT(0.0),
+    maxSecs(DBL_MAX),
+    timeUp(false),
+    nEvals(0),
+    incCost(DBL_MAX),
+    incF(-1),
+    incValue(0.0)
+{
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+        for ( size_t i=0 ; (i<nInsts) ; ++i )
+            fval[f*nInsts+i] = iset_->instance(i).float_feature(f);
+
+    // algorithms which are not cheaper than some other one in any
+    // instance are never needed: searches only the remaining ones
+    const size_t nAllAlgs = rset_->algsettings().size();
+    vector< int > kept;
+    for ( size_t a=0 ; (a<nAllAlgs) ; ++a )
+    {
+        bool dominated = false;
+        for ( size_t b=0 ; (b<nAllAlgs && !dominated) ; ++b )
+        {
+            if (a==b)
+                continue;
+            bool bNoWorse = true, bBetter = false;
+            for ( size_t i=0 ; (i<nInsts && bNoWorse) ; ++i )
+            {
+                const double ca = rset_->resInst(i)[a], cb = rset_->resInst(i)[b];
+                bNoWorse = (cb<=ca);
+                bBetter = bBetter || (cb<ca);
+            }
+            // identical algorithms: keeps the first one
+            dominated = bNoWorse && (bBetter || b<a);
+        }
+        if (!dominated)
+            kept.push_back( a );
+    }
+
+    nAlgs = kept.size();
+    res = new double[nInsts*nAlgs];
+    for ( size_t i=0 ; (i<nInsts) ; ++i )
+    {
+        for ( size_t j=0 ; (j<nAlgs) ; ++j )
+            res[i*nAlgs+j] = rset_->resInst(i)[kept[j]];
+        minInst[i] = *min_element( res+i*nAlgs, res+(i+1)*nAlgs );
+    }
+    for ( size_t j=0 ; (j<nAlgs) ; ++j )
+        rootSum.push_back( (double)rset_->results().sum()[kept[j]] );
+
+    for ( auto &v : sumL )
+        v.resize( nAlgs );
+    for ( auto &v : sumR )
+        v.resize( nAlgs );
+    sumD1.resize( nAlgs );
+
+    cout << "exact solver: " << nAlgs << " of " << nAllAlgs << " algorithms are not dominated" << endl;
+}
+
+DPTree::DPTree( const DPTree *shared ) :
+    iset_(shared->iset_),
+    rset_(shared->rset_),
+    nInsts(shared->nInsts),
+    nFeatures(shared->nFeatures),
+    nAlgs(shared->nAlgs),
+    nLevels(shared->nLevels),
+    fval(shared->fval),
+    res(shared->res),
+    rootSum(shared->rootSum),
+    minInst(shared->minInst),
+    ownData(false),
+    upperBound(DBL_MAX),
+    memo(nLevels+1),
+    side(nLevels+1, vector< char >(nInsts, 0)),
+    sumL(nLevels+1, vector< double >(nAlgs)),
+    sumR(nLevels+1, vector< double >(nAlgs)),
+    sumD1(nAlgs),
+    startT(0.0),
+    maxSecs(DBL_MAX),
+    timeUp(false),
+    nEvals(0),
+    incCost(DBL_MAX),
+    incF(-1),
+    incValue(0.0)
+{
+}
+
+void DPTree::setInitialSolution( const Tree *tree )
+{
+    // cost of the leafs computed as in the search
+    double cost = 0.0;
+    initF.clear();
+    initValue.clear();
+    vector< const Node * > queue;
+    queue.push_back( tree->root() );
+    while (queue.size())
+    {
+        const Node *node = queue.back();
+        queue.pop_back();
+        initF.push_back( node->isLeaf() ? -1 : (int)node->branchFeature() );
+        initValue.push_back( node->branchValue() );
+        if (node->isLeaf())
+        {
+            std::fill( sumD1.begin(), sumD1.end(), 0.0 );
+            for ( size_t i=0 ; (i<node->n_elements()) ; ++i )
+                split_kernel_add( &sumD1[0], resInst(node->elements()[i]), nAlgs );
+            cost += leafCost( &sumD1[0] );
+        }
+        else
+        {
+            queue.push_back( node->ichild(0) );
+            queue.push_back( node->ichild(1) );
+        }
+    }
+
+    // slightly above, so that an equivalent tree is always found
+    upperBound = cost + 1e-9*fabs(cost) + 1e-9;
+}
+
+Tree *DPTree::build( const int maxSeconds )
+{
+    cout << "running dynamic programming exact solver ... " << endl;
+    startT = omp_get_wtime();
+    maxSecs = (maxSeconds==INT_MAX) ? DBL_MAX : (double)maxSeconds;
+    timeUp = false;
+    nEvals = 0;
+    incCost = DBL_MAX;
+    incF = -1;
+
+    vector< int > ord( nFeatures*nInsts );
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+    {
+        const auto &o = iset_->instancesByFeatureVal(f);
+        std::copy( o.begin(), o.end(), ord.begin() + f*nInsts );
+    }
+
+    const double cost = solve( ord, &rootSum[0], nLevels, upperBound );
+    const double secs = omp_get_wtime()-startT;
+
+    if (timeUp)
+    {
+        cout << "time limit reached after " << secs << " seconds, optimality not proved." << endl;
+        if (incF<0)
+        {
+            cout << "no solution found, returning the initial tree" << endl << endl;
+            return initialTree();
+        }
+
+        cout << "returning best tree found, of cost " << incCost << endl << endl;
+        return incumbentTree();
+    }
+
+    if (cost>=upperBound)
+    {
+        cout << "no tree cheaper than the initial solution exists." << endl;
+        return initialTree();
+    }
+
+    size_t nSub = 0;
+    for ( const auto &m : memo )
+        nSub += m.size();
+
+    cout << "optimal solution of cost " << cost << " found in " << secs << " seconds, " <<
+        nSub << " subproblems stored, " << nEvals << " branches evaluated" << endl << endl;
+
+    Tree *tree = new Tree( iset_, rset_ );
+    Node *root = tree->create_root();
+    buildNode( tree, root, nLevels );
+    tree->computeCost();
+
+    return tree;
+}
+
+bool DPTree::expandNode( Tree *tree, Node *node, int levels, const double deadline )
+{
+    assert( levels>=0 && levels<=nLevels );
+    startT = omp_get_wtime();
+    maxSecs = (deadline==DBL_MAX) ? DBL_MAX : deadline-startT;
+    timeUp = (maxSecs<=0.0);
+    if (timeUp)
+        return false;
+
+    // subproblems of previous nodes are not needed anymore
+    for ( auto &m : memo )
+        m.clear();
+
+    vector< int > ord = sortedOrders( node->elements(), node->n_elements() );
+    vector< double > tot( nAlgs, 0.0 );
+    for ( size_t i=0 ; (i<node->n_elements()) ; ++i )
+        split_kernel_add( &tot[0], resInst(node->elements()[i]), nAlgs );
+
+    solve( ord, &tot[0], levels, DBL_MAX );
+    if (timeUp)
+        return false;
+
+    buildNode( tree, node, levels );
+
+    return true;
+}
+
+Tree *DPTree::incumbentTree()
+{
+    assert( incF>=0 );
+    Tree *tree = new Tree( iset_, rset_ );
+    Node *root = tree->create_root();
+    root->branchOnVal( incF, incValue );
+    tree->addNode( root->child()[0] );
+    tree->addNode( root->child()[1] );
+    buildNode( tree, root->child()[0], nLevels-1 );
+    buildNode( tree, root->child()[1], nLevels-1 );
+    tree->computeCost();
+
+    return tree;
+}
+
+Tree *DPTree::initialTree()
+{
+    Tree *tree = new Tree( iset_, rset_ );
+    Node *root = tree->create_root();
+
+    // same visiting order of setInitialSolution
+    size_t pos = 0;
+    vector< Node * > queue;
+    queue.push_back( root );
+    while (queue.size() && pos<initF.size())
+    {
+        Node *node = queue.back();
+        queue.pop_back();
+        const int idxF = initF[pos];
+        const double value = initValue[pos];
+        ++pos;
+        if (idxF<0)
+            continue;
+
+        node->branchOnVal( idxF, value );
+        tree->addNode( node->child()[0] );
+        tree->addNode( node->child()[1] );
+        queue.push_back( node->child()[0] );
+        queue.push_back( node->child()[1] );
+    }
+    tree->computeCost();
+
+    return tree;
+}
+
+void DPTree::newIncumbent( int idxF, double value, double cost, double lb )
+{
+    incCost = cost;
+    incF = idxF;
+    incValue = value;
+
+    if (Parameters::anytime<=0)
+        return;
+
+    Tree *tree = incumbentTree();
+    tree->saveFiles();
+    const double secs = omp_get_wtime()-startT;
+    cout << endl << "improved tree of cost " << cost << " saved, lower bound " << lb << ", " <<
+        idxF+1 << " of " << nFeatures << " root features explored, " << secs << " seconds" << endl;
+    delete tree;
+}
+
+void DPTree::buildNode( Tree *tree, Node *node, int k )
+{
+    if (k==0 || (int)node->n_elements()<2*Parameters::minElementsBranch)
+        return;
+
+    int idxF = -1;
+    double value = 0.0;
+    vector< int > ord = sortedOrders( node->elements(), node->n_elements() );
+    if (k==1)
+    {
+        std::fill( sumR[0].begin(), sumR[0].end(), 0.0 );
+        for ( size_t i=0 ; (i<node->n_elements()) ; ++i )
+            split_kernel_add( &sumR[0][0], resInst(node->elements()[i]), nAlgs );
+        solveDepth1( &ord[0], (int)node->n_elements(), nullptr, 0, (int)node->n_elements(),
+                &sumR[0][0], &idxF, &value );
+    }
+    else
+    {
+        vector< int > key( ord.begin(), ord.begin()+node->n_elements() );
+        std::sort( key.begin(), key.end() );
+        auto it = memo[k].find( key );
+        assert( it != memo[k].end() && it->second.exact );
+        idxF = it->second.idxF;
+        value = it->second.value;
+    }
+
+    if (idxF<0)
+        return;
+
+    node->branchOnVal( idxF, value );
+    tree->addNode( node->child()[0] );
+    tree->addNode( node->child()[1] );
+    buildNode( tree, node->child()[0], k-1 );
+    buildNode( tree, node->child()[1], k-1 );
+}
+
+vector< int > DPTree::sortedOrders( const size_t *el, size_t n ) const
+{
+    vector< char > inNode( nInsts, 0 );
+    for ( size_t i=0 ; (i<n) ; ++i )
+        inNode[el[i]] = 1;
+
+    vector< int > ord;
+    ord.reserve( nFeatures*n );
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+        for ( auto i : iset_->instancesByFeatureVal(f) )
+            if (inNode[i])
+                ord.push_back( i );
+
+    return ord;
+}
+
+double DPTree::leafCost( const double *tot ) const
+{
+    return *min_element( tot, tot+nAlgs );
+}
+
+bool DPTree::checkTime()
+{
+    if (timeUp)
+        return true;
+    if (maxSecs==DBL_MAX)
+        return false;
+
+    const double secs = omp_get_wtime()-startT;
+    timeUp = (secs>=maxSecs);
+
+    return timeUp;
+}
+
+double DPTree::solve( const vector< int > &ord, const double *tot, int k, double ub )
+{
+    const int m = (int)(ord.size()/nFeatures);
+
+    if (k==0 || m<2*Parameters::minElementsBranch)
+        return leafCost( tot );
+
+    if (k==1)
+    {
+        int idxF = -1;
+        double value = 0.0;
+        return solveDepth1( &ord[0], m, nullptr, 0, m, tot, &idxF, &value );
+    }
+
+    vector< int > key( ord.begin(), ord.begin()+m );
+    std::sort( key.begin(), key.end() );
+    auto &mk = memo[k];
+    auto it = mk.find( key );
+    if (it != mk.end())
+    {
+        if (it->second.exact || it->second.cost>=ub)
+            return it->second.cost;
+    }
+
+    DPEntry e;
+    const double cost = solveBranch( ord, tot, k, ub, e );
+    if (timeUp)
+        return cost;
+
+    if (cost<ub)
+    {
+        e.exact = true;
+        e.cost = cost;
+    }
+    else
+    {
+        // only known that no solution is cheaper than ub
+        e.exact = false;
+        e.cost = ub;
+    }
+    mk[key] = e;
+
+    return cost;
+}
+
+double DPTree::solveDepth1( const int *ord, int m, const char *inSub, char s, int cnt,
+        const double *tot, int *bestF, double *bestVal )
+{
+    const int minEl = Parameters::minElementsBranch;
+
+    double best = leafCost( tot );
+    *bestF = -1;
+
+    if (cnt<2*minEl || cnt<2)
+        return best;
+
+    double *sl = &sumD1[0];
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+    {
+        const int *o = ord + f*m;
+        const double *fv = fval + f*nInsts;
+        std::fill( sl, sl+nAlgs, 0.0 );
+        int nLeft = 0;
+        int prev = -1;
+        for ( int j=0 ; (j<m) ; ++j )
+        {
+            const int i = o[j];
+            if (inSub && inSub[i]!=s)
+                continue;
+
+            if (cnt-nLeft<minEl)
+                break;
+
+            if (nLeft>=minEl && nLeft>0 && fv[i]-fv[prev]>=1e-10)
+            {
+                double costL = DBL_MAX, costR = DBL_MAX;
+                split_kernel_min_lr( sl, tot, nAlgs, &costL, &costR );
+                ++nEvals;
+                if (costL+costR<best)
+                {
+                    best = costL+costR;
+                    *bestF = (int)f;
+                    *bestVal = fv[prev];
+                }
+            }
+
+            split_kernel_add( sl, resInst(i), nAlgs );
+            ++nLeft;
+            prev = i;
+        }
+    }
+
+    return best;
+}
+
+double DPTree::solveBranch( const vector< int > &ord, const double *tot, int k, double ub, DPEntry &e )
+{
+    const int m = (int)(ord.size()/nFeatures);
+    const int minEl = Parameters::minElementsBranch;
+
+    double best = leafCost( tot );
+    e.idxF = -1;
+
+    // lower bound: cheapest algorithm for each instance
+    double lbS = 0.0;
+    for ( int j=0 ; (j<m) ; ++j )
+        lbS += minInst[ord[j]];
+
+    if (best<=lbS || lbS>=ub)
+        return std::max( best, lbS );
+
+    char *sd = &side[k][0];
+    double *sl = &sumL[k][0];
+    double *sr = &sumR[k][0];
+    vector< int > ordL, ordR;
+
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+    {
+        if (checkTime())
+            break;
+
+        const int *o = &ord[f*m];
+        const double *fv = fval + f*nInsts;
+        for ( int j=0 ; (j<m) ; ++j )
+            sd[o[j]] = 1;
+        std::fill( sl, sl+nAlgs, 0.0 );
+        double lbL = 0.0;
+
+        for ( int p=1 ; (p<=m-minEl) ; ++p )
+        {
+            const int i = o[p-1];
+            sd[i] = 0;
+            split_kernel_add( sl, resInst(i), nAlgs );
+            lbL += minInst[i];
+
+            if (p<minEl || fv[o[p]]-fv[i]<1e-10)
+                continue;
+
+            const double bound = std::min( best, ub );
+            // no branch can improve
+            if (lbS>=bound)
+                goto done;
+
+            const double lbR = lbS-lbL;
+            for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+                sr[ia] = tot[ia] - sl[ia];
+
+            double costL, costR;
+            if (k==2)
+            {
+                // each cut solves both children: checks time at every cut
+                if (checkTime())
+                    goto done;
+                int idxF;
+                double value;
+                costL = solveDepth1( &ord[0], m, sd, 0, p, sl, &idxF, &value );
+                if (costL+lbR>=bound)
+                    continue;
+                costR = solveDepth1( &ord[0], m, sd, 1, m-p, sr, &idxF, &value );
+            }
+            else
+            {
+                // stable partition of the orders of all features
+                ordL.resize( nFeatures*p );
+                ordR.resize( nFeatures*(m-p) );
+                for ( size_t f2=0 ; (f2<nFeatures) ; ++f2 )
+                {
+                    int *dl = &ordL[f2*p];
+                    int *dr = &ordR[f2*(m-p)];
+                    const int *o2 = &ord[f2*m];
+                    for ( int j=0 ; (j<m) ; ++j )
+                    {
+                        if (sd[o2[j]])
+                            *(dr++) = o2[j];
+                        else
+                            *(dl++) = o2[j];
+                    }
+                }
+
+                const double ubL = bound-lbR;
+                costL = solve( ordL, sl, k-1, ubL );
+                if (timeUp)
+                    goto done;
+                if (costL>=ubL)
+                    continue;
+                const double ubR = bound-costL;
+                costR = solve( ordR, sr, k-1, ubR );
+                if (timeUp)
+                    goto done;
+                if (costR>=ubR)
+                    continue;
+            }
+
+            if (costL+costR<best)
+            {
+                best = costL+costR;
+                e.idxF = (int)f;
+                e.value = fv[i];
+                // children of the root were solved exactly
+                if (k==nLevels && m==(int)nInsts && best<upperBound)
+                    newIncumbent( e.idxF, e.value, best, lbS );
+            }
+        }
+    }
+done:
+
+    return best;
+}
+
+DPTree::~DPTree ()
+{
+    if (!ownData)
+        return;
+
+    delete[] fval;
+    delete[] res;
+    delete[] minInst;
+}
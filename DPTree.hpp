@@ -0,0 +1,170 @@
+/*
+ * DPTree.hpp
+ */
+
+#ifndef DPTREE_HPP_
+#define DPTREE_HPP_
+
+class InstanceSet;
+class ResultsSet;
+class Tree;
+class Node;
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <climits>
+#include <cfloat>
+
+// solution of a subproblem: a subset of instances
+// with some number of branching levels available
+struct DPEntry
+{
+    DPEntry() :
+        exact(false),
+        cost(0.0),
+        idxF(-1),
+        value(0.0)
+    {}
+
+    // if cost is the optimal cost or only a lower bound
+    bool exact;
+    double cost;
+
+    // branch of the optimal solution, -1 if leaf
+    int idxF;
+    double value;
+};
+
+struct DPSubsetHash
+{
+    size_t operator()( const std::vector< int > &el ) const {
+        size_t h = 14695981039346656037ULL;
+        for ( auto i : el )
+            h = (h ^ (size_t)i) * 1099511628211ULL;
+        return h;
+    }
+};
+
+// builds optimal trees without a MIP solver: (feature, threshold)
+// pairs are searched recursively up to maxDepth, with a special
+// case for subtrees of depth two, subproblems memoized by instance
+// subset and pruned with lower bounds from the cheapest algorithm
+// of each instance
+class DPTree
+{
+public:
+    DPTree( const InstanceSet *_iset, const ResultsSet *_rset );
+
+    // solver for another thread: uses the feature values and the results
+    // of the non dominated algorithms of shared, which must outlive it,
+    // only the search data is allocated
+    DPTree( const DPTree *shared );
+
+    // cost of tree is used as upper bound
+    void setInitialSolution( const Tree *tree );
+
+    // optimal tree or, if it could not be improved or no solution was
+    // found in maxSeconds, a copy of the initial solution
+    Tree *build( const int maxSeconds = INT_MAX );
+
+    // builds the optimal subtree with the given number of branching
+    // levels below leaf node, adding its nodes to tree. returns false
+    // if deadline (absolute omp_get_wtime() time) is reached, leaving
+    // node a leaf
+    bool expandNode( Tree *tree, Node *node, int levels, const double deadline = DBL_MAX );
+
+    virtual ~DPTree ();
+private:
+    const InstanceSet *iset_;
+    const ResultsSet *rset_;
+
+    size_t nInsts;
+
+    size_t nFeatures;
+
+    // algorithms which are not dominated
+    size_t nAlgs;
+
+    // levels where nodes can be branched
+    int nLevels;
+
+    // feature values, feature major
+    double *fval;
+
+    // results of the non dominated algorithms
+    // for each instance and their sum
+    double *res;
+    std::vector< double > rootSum;
+
+    const double *resInst( size_t idxInst ) const {
+        return res + idxInst*nAlgs;
+    }
+
+    // cost of the cheapest algorithm of each instance
+    double *minInst;
+
+    // if fval, res and minInst were allocated by this object
+    bool ownData;
+
+    double upperBound;
+
+    // branches of the initial solution as visited by
+    // setInitialSolution, initF is -1 in leafs
+    std::vector< int > initF;
+    std::vector< double > initValue;
+
+    // optimal cost of subsets, per number of levels
+    std::vector< std::unordered_map< std::vector< int >, DPEntry, DPSubsetHash > > memo;
+
+    // per level, side of each instance and sums of results
+    std::vector< std::vector< char > > side;
+    std::vector< std::vector< double > > sumL;
+    std::vector< std::vector< double > > sumR;
+    std::vector< double > sumD1;
+
+    double startT;
+    double maxSecs;
+    bool timeUp;
+    size_t nEvals;
+
+    // best branch of the root found so far
+    double incCost;
+    int incF;
+    double incValue;
+
+    // cost of the best solution for the instances in ord, which has
+    // the instances sorted by each feature. if no solution cheaper
+    // than ub exists, returns a value >= ub
+    double solve( const std::vector< int > &ord, const double *tot, int k, double ub );
+
+    // best single branch (or leaf) for the elements of ord with
+    // inSub[el]==s or for all elements of ord if inSub is null
+    double solveDepth1( const int *ord, int m, const char *inSub, char s, int cnt,
+            const double *tot, int *bestF, double *bestVal );
+
+    // best branch of a subset with k>=2 levels, depth2 uses
+    // solveDepth1 directly for the children
+    double solveBranch( const std::vector< int > &ord, const double *tot, int k, double ub, DPEntry &e );
+
+    bool checkTime();
+
+    // instances of a node sorted by each feature
+    std::vector< int > sortedOrders( const size_t *el, size_t n ) const;
+
+    void buildNode( Tree *tree, Node *node, int k );
+
+    // tree of the best root branch found so far
+    Tree *incumbentTree();
+
+    // copy of the initial solution, only the root if none was set
+    Tree *initialTree();
+
+    // records an improved root branch, saving its tree
+    // when Parameters::anytime is set
+    void newIncumbent( int idxF, double value, double cost, double lb );
+
+    double leafCost( const double *tot ) const;
+};
+
+#endif /* DPTREE_HPP_ */
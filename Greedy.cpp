@@ -15,6 +15,13 @@
 #include <utility>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <random>
+#include <chrono>
+#include <tuple>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "Greedy.hpp"
 #include "InstanceSet.hpp"
@@ -23,6 +30,7 @@
 #include "Parameters.hpp"
 #include "SubSetResults.hpp"
 #include "Node.hpp"
+#include "SplitKernel.hpp"
 
 using namespace std;
 
@@ -32,100 +40,183 @@ typedef struct
     double val;
 } ElVal;
 
+// best split found: the partition is rebuilt
+// from the sorted order of idxFeature
 class SplitInfo
 {
 public:
-    SplitInfo( size_t nAlgs, size_t nInsts ) :
-        sumRL( new long double[nAlgs] ),
-        sumRR( new long double[nAlgs] ),
-        elv(new ElVal[nInsts]),
+    SplitInfo() :
         splitCost(DBL_MAX),
         idxFeature(numeric_limits<size_t>::max()),
-        nElLeft(0)
+        nElLeft(0),
+        cutValue(0.0)
     {}
 
-    virtual ~SplitInfo() {
-        delete[] sumRL;
-        delete[] sumRR;
-    }
-
-    long double *sumRL;
-    long double *sumRR;
-    ElVal *elv;
-    long double splitCost;
+    double splitCost;
     size_t idxFeature;
     int nElLeft;
+    double cutValue;
+};
+
+// a node of the tree being built which will still be
+// branched: its elements are a range of the sorted
+// orders of its level
+class GNode
+{
+public:
+    GNode( size_t _depth, size_t _start, int _nEl, size_t nAlgs ) :
+        depth(_depth),
+        start(_start),
+        nEl(_nEl),
+        sumRes( new double[nAlgs] ),
+        hist(nullptr),
+        histCnt(nullptr)
+    {
+        child[0] = child[1] = nullptr;
+    }
+
+    virtual ~GNode() {
+        freeHist();
+        delete[] sumRes;
+    }
+
+    void freeHist() {
+        delete[] hist;
+        delete[] histCnt;
+        hist = nullptr;
+        histCnt = nullptr;
+    }
+
+    size_t depth;
+
+    // position of the first element of this node
+    // in the sorted orders of its level
+    size_t start;
+    int nEl;
+
+    // sum of results of each algorithm in this node
+    double *sumRes;
+
+    // when branching on bins: sum of results per
+    // feature, bin and algorithm and number of
+    // instances per feature and bin
+    double *hist;
+    int *histCnt;
+
+    // filled when branching, if children will also be branched
+    GNode *child[2];
 };
 
+// state of the scan of the features of one node,
+// one per thread
 class GNodeData {
 public:
     GNodeData( const InstanceSet *_iset, const ResultsSet *_rset ) :
         iset_(_iset),
         rset_(_rset),
-        idx(0),
-        sumResR( new long double[rset_->algsettings().size()] ),
-        sumResL( new long double[rset_->algsettings().size()] ),
+        depth(0),
+        start(0),
+        sumRes(nullptr),
+        sumResL( new double[rset_->algsettings().size()] ),
         elv( new ElVal[iset_->size()] ),
         nEl(iset_->size()),
         nElLeft(0),
         splitCost(DBL_MAX),
         idxFeature(numeric_limits<size_t>::max()),
-        bestSplit(SplitInfo(rset_->algsettings().size(), iset_->size()))
+        featPrio(nullptr),
+        minEl(Parameters::minElementsBranch),
+        bestCutL(nullptr),
+        bestCutR(nullptr)
     { 
-        for ( auto i=0 ; (i<iset_->size()) ; ++i )
-            elv[i].el = i;
-        for ( size_t i=0 ; (i<rset_->algsettings().size()) ; ++i )
-            sumResR[i] = rset_->results().sum()[i];
         for ( size_t i=0 ; (i<rset_->algsettings().size()) ; ++i )
             sumResL[i] = 0.0;
     }
 
     virtual ~GNodeData() {
+        delete[] bestCutL;
+        delete[] bestCutR;
         delete[] elv;
-        delete[] sumResR;
         delete[] sumResL;
     }
 
+    // only the left side is updated, right
+    // side sums are sumRes-sumResL
     void moveInstanceLeft( size_t idxInst )
     {
-        for ( size_t ia=0 ; (ia<rset_->algsettings().size()) ; ++ia )
-        {
-            sumResR[ia] -= ((long double)rset_->res(idxInst, ia));
-            sumResL[ia] += ((long double)rset_->res(idxInst, ia));
+        split_kernel_add( sumResL, rset_->resInst(idxInst), rset_->algsettings().size() );
+    }
 
-#ifdef DEBUG
-            assert( sumResR[ia] >= -1e-5 );
-            assert( sumResL[ia] >= -1e-5 );
-#endif
+    void updateBestAlg() {
+        assert( nElLeft >= minEl && (nEl-nElLeft)>=minEl );
+        double costBestAlgL = DBL_MAX, costBestAlgR = DBL_MAX;
+
+        split_kernel_min_lr( sumResL, sumRes, rset_->algsettings().size(), &costBestAlgL, &costBestAlgR );
+
+        splitCost = costBestAlgL + costBestAlgR;
+
+        if (improvesBest()) {
+            bestSplit.splitCost = splitCost;
+            bestSplit.nElLeft = this->nElLeft;
+            bestSplit.idxFeature = idxFeature;
+            bestSplit.cutValue = cutValue();
         }
     }
 
-    void updateBestAlg() {
-        assert( nElLeft >= Parameters::minElementsBranch && (nEl-nElLeft)>=Parameters::minElementsBranch );
-        long double costBestAlgL = DBL_MAX;
+    // scans the current feature keeping only nCand candidate algorithms
+    // per side. instAlgs has, for each instance, its nCand+1 cheapest
+    // algorithms: the cost of a non candidate algorithm grows at least
+    // by the cheapest non candidate of each instance added to its side,
+    // while this bound keeps them above the best candidate they are
+    // not updated
+    void scanPruned( const int *instAlgs, int nCand ) {
+        if (nEl<2*minEl || nEl<2)
+            return;
+
+        if (bestCutL==nullptr)
+        {
+            bestCutL = new double[iset_->size()+1];
+            bestCutR = new double[iset_->size()+1];
+        }
 
-        for ( size_t ia=0 ; (ia<rset_->algsettings().size()) ; ++ia )
-            if (sumResL[ia]<costBestAlgL)
-                costBestAlgL = sumResL[ia];
+        validCut.assign( nEl+1, 0 );
+        for ( int p=std::max(minEl,1) ; (p<=nEl-minEl) ; ++p )
+            validCut[p] = (elv[p].val-elv[p-1].val>=1e-10);
 
-        long double costBestAlgR = DBL_MAX;
+        prunedPass( instAlgs, nCand, false );
+        prunedPass( instAlgs, nCand, true );
 
-        for ( size_t ia=0 ; (ia<rset_->algsettings().size()) ; ++ia )
-            if (sumResR[ia]<costBestAlgR)
-                costBestAlgR = sumResR[ia];
+        // first cheapest position, as in the complete scan
+        int bestP = -1;
+        for ( int p=1 ; (p<nEl) ; ++p )
+            if (validCut[p] && (bestP==-1 || bestCutL[p]+bestCutR[p]<bestCutL[bestP]+bestCutR[bestP]))
+                bestP = p;
 
-        splitCost = costBestAlgL + costBestAlgR;
+        if (bestP==-1)
+            return;
 
-        if (splitCost<bestSplit.splitCost) {
+        nElLeft = bestP;
+        splitCost = bestCutL[bestP]+bestCutR[bestP];
+        if (improvesBest()) {
             bestSplit.splitCost = splitCost;
             bestSplit.nElLeft = this->nElLeft;
-            memcpy( bestSplit.sumRL, this->sumResL, sizeof(long double)*rset_->algsettings().size() );
-            memcpy( bestSplit.sumRR, this->sumResR, sizeof(long double)*rset_->algsettings().size() );
             bestSplit.idxFeature = idxFeature;
-            memcpy( bestSplit.elv, this->elv, sizeof(ElVal)*this->nEl );
+            bestSplit.cutValue = cutValue();
         }
     }
 
+    // ties are broken by the smallest feature priority, so that the
+    // result does not depend on the order features are scanned
+    size_t tieKey( size_t f ) const {
+        if (featPrio==nullptr || f==numeric_limits<size_t>::max())
+            return f;
+        return featPrio[f];
+    }
+
+    bool improvesBest() const {
+        return ( splitCost<bestSplit.splitCost ||
+             (splitCost==bestSplit.splitCost && tieKey(idxFeature)<tieKey(bestSplit.idxFeature)) );
+    }
+
     double cutValue() const {
         // is in a valid branching position
         assert( nElLeft >=1 && nElLeft<nEl );
@@ -139,13 +230,13 @@ public:
 
 goNext:
         ++nElLeft;
-        if ( ((int)nElLeft)>((int)nEl)-((int)Parameters::minElementsBranch) )
+        if ( ((int)nElLeft)>((int)nEl)-minEl )
             return false;
 
         const double diff = elv[nElLeft].val - elv[nElLeft-1].val;
         assert( diff>=0.0 );
 
-        if (diff>=1e-10 and nElLeft>=Parameters::minElementsBranch)
+        if (diff>=1e-10 and nElLeft>=minEl)
                 return true;
         else
         {
@@ -159,149 +250,591 @@ goNext:
     const InstanceSet *iset_;
     const ResultsSet *rset_;
     
-    size_t idx;
-    long double *sumResR;
-    long double *sumResL;
+    // fills bestCutL (or bestCutR, if reverse) with the cost of the
+    // best algorithm in the left (right) side of each valid cut,
+    // adding instances in sorted (reverse) order. sumResL holds the
+    // sums of all algorithms up to position p0, candidates have
+    // their own sums, always up to date
+    void prunedPass( const int *instAlgs, int nCand, bool reverse ) {
+        const int nAlgs = (int)rset_->algsettings().size();
+        double *bestCut = reverse ? bestCutR : bestCutL;
+        const int nIA = nCand+1;
+        nCand = std::min( nCand, nAlgs );
+
+        std::fill( sumResL, sumResL+nAlgs, 0.0 );
+        cand.resize( nCand );
+        candSum.resize( nCand );
+        algIdx.resize( nAlgs );
+        isCand.assign( nAlgs, 0 );
+
+        // initial candidates: cheapest in the whole node
+        for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+            algIdx[ia] = ia;
+        const double *sr = sumRes;
+        std::nth_element( algIdx.begin(), algIdx.begin()+(nCand-1), algIdx.end(),
+            [sr] ( int a1, int a2 ) { return sr[a1]<sr[a2] || (sr[a1]==sr[a2] && a1<a2); } );
+        for ( int j=0 ; (j<nCand) ; ++j )
+        {
+            cand[j] = algIdx[j];
+            candSum[j] = 0.0;
+            isCand[cand[j]] = 1;
+        }
+
+        // smallest sum of a non candidate at p0 and lower
+        // bound on what all of them received after p0
+        double theta = (nCand<nAlgs) ? 0.0 : DBL_MAX;
+        double grown = 0.0;
+        int p0 = 0;
+
+        for ( int q=1 ; (q<nEl) ; ++q )
+        {
+            const size_t el = reverse ? elv[nEl-q].el : elv[q-1].el;
+            const double *r = rset_->resInst( el );
+            for ( int j=0 ; (j<nCand) ; ++j )
+                candSum[j] += r[cand[j]];
+            if (nCand<nAlgs)
+            {
+                const int *ia = instAlgs + el*nIA;
+                while (isCand[*ia])
+                    ++ia;
+                grown += r[*ia];
+            }
+
+            const int p = reverse ? nEl-q : q;
+            if (!validCut[p])
+                continue;
+
+            double best = *std::min_element( candSum.begin(), candSum.end() );
+            if (theta + grown < best)
+            {
+                // bound crossed: updates all sums and selects new candidates
+                for ( int i=p0 ; (i<q) ; ++i )
+                    split_kernel_add( sumResL, rset_->resInst( reverse ? elv[nEl-1-i].el : elv[i].el ), nAlgs );
+                p0 = q;
+                grown = 0.0;
+
+                const double *sl = sumResL;
+                std::nth_element( algIdx.begin(), algIdx.begin()+nCand, algIdx.end(),
+                    [sl] ( int a1, int a2 ) { return sl[a1]<sl[a2]; } );
+                theta = sl[algIdx[nCand]];
+                for ( int j=0 ; (j<nCand) ; ++j )
+                {
+                    isCand[cand[j]] = 0;
+                    cand[j] = algIdx[j];
+                    candSum[j] = sl[algIdx[j]];
+                }
+                for ( int j=0 ; (j<nCand) ; ++j )
+                    isCand[cand[j]] = 1;
+                best = *std::min_element( candSum.begin(), candSum.end() );
+            }
+            bestCut[p] = best;
+        }
+    }
+
+    // node being scanned
+    size_t depth;
+    size_t start;
+
+    // sums of results in the node and in the
+    // left side of the current split
+    const double *sumRes;
+    double *sumResL;
     ElVal *elv;
     int nEl;
 
     int nElLeft;
 
-    long double splitCost;
+    double splitCost;
 
     // feature being branched on
     size_t idxFeature;
 
+    // priority of each feature in ties, if null the feature index
+    const int *featPrio;
+
+    // minimum number of elements in each side
+    int minEl;
+
     SplitInfo bestSplit;
+
+    // when scanning with candidate algorithms: cost of the best
+    // algorithm in each side for each number of elements in the left
+    double *bestCutL;
+    double *bestCutR;
+    std::vector< char > validCut;
+    std::vector< int > cand;
+    std::vector< char > isCand;
+    std::vector< double > candSum;
+    std::vector< int > algIdx;
 };
 
 Greedy::Greedy (const InstanceSet *_iset, const ResultsSet *_rset) :
     iset_(_iset),
     rset_(_rset),
-    ndata(nullptr),
-    tnodes(0),
-    maxDepth(Parameters::maxDepth)
+    maxDepth(Parameters::maxDepth),
+    nLevels(std::max( (size_t)1, maxDepth-1 )),
+    sorted(nullptr),
+    toLeft(nullptr),
+    nThreads(1),
+    wdata(nullptr),
+    nBins(0),
+    minElementsBranch(Parameters::minElementsBranch),
+    instAlgs(nullptr)
 {
-    for ( size_t i=0 ; (i<maxDepth) ; ++i )
-        tnodes += (size_t)pow( 2.0, i)+1e-10;
+    // sorted orders of each feature: nodes of the same level occupy
+    // disjoint ranges and children only write inside the range of
+    // their parent, so two buffers, alternated by level, suffice
+    const size_t nInsts = iset_->size();
+    const size_t nFeatures = iset_->features().size();
+    const size_t nBuffers = std::min( nLevels, (size_t)2 );
+    sorted = new int*[2];
+    sorted[0] = new int[nBuffers*nFeatures*nInsts];
+    sorted[1] = sorted[0] + (nBuffers-1)*nFeatures*nInsts;
 
-    ndata = new GNodeData*[tnodes];
-    for ( size_t i=0 ; (i<tnodes) ; ++i ) 
+    toLeft = new bool[nInsts];
+
+    if (Parameters::greedyBins>0)
     {
-        ndata[i] = new GNodeData(iset_, rset_);
-        ndata[i]->idx = 0;
+        binStart = vector< size_t >( nFeatures+1, 0 );
+        for ( size_t f=0 ; (f<nFeatures) ; ++f )
+            binStart[f+1] = binStart[f] + iset_->nBinsFeature(f);
+        nBins = binStart[nFeatures];
     }
+
+    const int nAlgs = (int)rset_->algsettings().size();
+    if (Parameters::greedyCandAlgs>0 && Parameters::greedyCandAlgs<nAlgs)
+    {
+        // cheapest algorithms of each instance
+        const int nIA = Parameters::greedyCandAlgs+1;
+        instAlgs = new int[nInsts*nIA];
+        vector< int > algs( nAlgs );
+        for ( size_t i=0 ; (i<nInsts) ; ++i )
+        {
+            const double *r = rset_->resInst(i);
+            for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+                algs[ia] = ia;
+            std::partial_sort( algs.begin(), algs.begin()+nIA, algs.end(),
+                [r] ( int a1, int a2 ) { return r[a1]<r[a2]; } );
+            std::copy( algs.begin(), algs.begin()+nIA, instAlgs+i*nIA );
+        }
+    }
+
+#ifdef _OPENMP
+    nThreads = (Parameters::threads>=1) ? Parameters::threads : omp_get_num_procs();
+    nThreads = std::min( nThreads, std::max( (int)nFeatures, 1 ) );
+    // objects created by threads, as the ones building
+    // portfolio trees, scan features sequentially
+    if (omp_in_parallel())
+        nThreads = 1;
+#endif
+
+    // scratch data for scanning features, one per thread
+    wdata = new GNodeData*[nThreads];
+    for ( int i=0 ; (i<nThreads) ; ++i )
+        wdata[i] = new GNodeData(iset_, rset_);
 }
 
 Tree *Greedy::build()
 {
     clock_t start = clock();
     cout << "running greedy constructive ... " << endl;
-    vector< pair< size_t, Node *> > nqueue;
+
+    Tree *res = buildTree();
+    
+    const double secs = ((double)clock()-(double)start) / ((double)CLOCKS_PER_SEC);
+    cout << "solution of cost " << res->cost() << " generated in " << secs << " seconds" << endl << endl;
+
+    return res;
+}
+
+Tree *Greedy::buildTree()
+{
+    // root orders are computed only once, in the instance set
+    const size_t nInsts = iset_->size();
+    for ( size_t f=0 ; (f<iset_->features().size()) ; ++f )
+    {
+        const auto &ord = iset_->instancesByFeatureVal(f);
+        std::copy( ord.begin(), ord.end(), sorted[0] + f*nInsts );
+    }
 
     Tree *res = new Tree(iset_, rset_);
 
     Node *root = res->create_root();
 
-    nqueue.push_back( make_pair((size_t)0, root) );
+    // nodes which will be branched
+    const size_t nAlgs = rset_->algsettings().size();
+    GNode *groot = new GNode( 0, 0, iset_->size(), nAlgs );
+    for ( size_t i=0 ; (i<nAlgs) ; ++i )
+        groot->sumRes[i] = rset_->results().sum()[i];
 
-    while (nqueue.size())
+    grow( res, root, groot );
+
+    res->computeCost();
+
+    return res;
+}
+
+void Greedy::expandNode( Tree *tree, Node *node )
+{
+    const size_t depth = (size_t)node->depth();
+    if (depth>=nLevels)
+        return;
+
+    // orders of the instances of node, in the buffer of its level
+    const size_t nInsts = iset_->size();
+    const size_t nEl = node->n_elements();
+    vector< char > inNode( nInsts, 0 );
+    for ( size_t i=0 ; (i<nEl) ; ++i )
+        inNode[node->elements()[i]] = 1;
+    for ( size_t f=0 ; (f<iset_->features().size()) ; ++f )
     {
-        pair< size_t, Node *> np = nqueue.back();
-        Node *node = np.second;
-        nqueue.pop_back();
+        int *dst = sorted[depth%2] + f*nInsts;
+        for ( auto i : iset_->instancesByFeatureVal(f) )
+            if (inNode[i])
+                *(dst++) = i;
+    }
 
-        size_t idxLeft = 2*np.first+1;
-        size_t idxRight = 2*np.first+2;
+    const size_t nAlgs = rset_->algsettings().size();
+    GNode *gn = new GNode( depth, 0, (int)nEl, nAlgs );
+    std::fill( gn->sumRes, gn->sumRes+nAlgs, 0.0 );
+    for ( size_t i=0 ; (i<nEl) ; ++i )
+        split_kernel_add( gn->sumRes, rset_->resInst(node->elements()[i]), nAlgs );
 
-        // if children will be will within max depth
-        if (idxLeft >= tnodes) 
-            break;
+    grow( tree, node, gn );
+}
 
-        GNodeData *gnd = ndata[np.first];
+void Greedy::grow( Tree *res, Node *root, GNode *groot )
+{
+    if (maxDepth<2)
+        delete groot;
+    else if (Parameters::greedyBreadthFirst)
+        buildLevels( res, root, groot );
+    else
+    {
+        vector< pair< GNode *, Node *> > nqueue;
+        nqueue.push_back( make_pair(groot, root) );
 
-        gnd->bestSplit.splitCost = DBL_MAX;
-        gnd->bestSplit.idxFeature = numeric_limits<size_t>::max();
-        for ( size_t idxFeature=0 ; (idxFeature<iset_->features().size()) ; ++idxFeature )
+        while (nqueue.size())
         {
-            prepareBranch( np.first, idxFeature );
-            while (gnd->next())
-                gnd->updateBestAlg();
+            pair< GNode *, Node *> np = nqueue.back();
+            GNode *gn = np.first;
+            Node *node = np.second;
+            nqueue.pop_back();
+
+            if (branch( gn, node, (nThreads>1) ))
+            {
+                if (gn->child[0])
+                {
+                    nqueue.push_back( make_pair( gn->child[0], node->child()[0]) );
+                    nqueue.push_back( make_pair( gn->child[1], node->child()[1]) );
+                }
+
+                res->addNode(node->child()[0]);
+                res->addNode(node->child()[1]);
+            }
+            delete gn;
         }
-        
-        // found a valid branch
-        if (gnd->bestSplit.idxFeature != numeric_limits<size_t>::max())
+    }
+}
+
+void Greedy::buildLevels( Tree *res, Node *root, GNode *groot )
+{
+    vector< pair< GNode *, Node *> > level;
+    level.push_back( make_pair(groot, root) );
+
+    while (level.size())
+    {
+        const int nNodes = (int)level.size();
+        vector< char > branched( nNodes, 0 );
+
+        if (nNodes<nThreads)
         {
-            // recover to best state
-            gnd->nElLeft = gnd->bestSplit.nElLeft;
-            memcpy( gnd->sumResL, gnd->bestSplit.sumRL, sizeof(long double)*rset_->algsettings().size() );
-            memcpy( gnd->sumResR, gnd->bestSplit.sumRR, sizeof(long double)*rset_->algsettings().size() );
-            gnd->splitCost = gnd->bestSplit.splitCost;
-            memcpy(gnd->elv , gnd->bestSplit.elv, sizeof(ElVal)*gnd->nEl );
-            gnd->idxFeature = gnd->bestSplit.idxFeature;
-            // update child node elements
-            auto *gndLeft = ndata[idxLeft];
-            gndLeft->nEl = gnd->nElLeft;
-            for ( int ie=0 ; (ie<gnd->nElLeft) ; ++ie )
-                gndLeft->elv[ie].el = gnd->elv[ie].el;
-            auto *gndRight = ndata[idxRight];
-            gndRight->nEl = gnd->nEl-gnd->nElLeft;
-            size_t ii = 0;
-            for ( int ie=gnd->nElLeft ; (ie<gnd->nEl) ; ++ie,++ii )
-                gndRight->elv[ii].el = gnd->elv[ie].el;
-
-            node->branchOnVal( gnd->idxFeature, gnd->cutValue() );
-
-            nqueue.push_back( make_pair( (size_t) idxLeft, node->child()[0]) );
-            nqueue.push_back( make_pair( (size_t) idxRight, node->child()[1]) );
-
-            res->addNode(node->child()[0]);
-            res->addNode(node->child()[1]);
+            // few nodes: parallel over features of each node
+            for ( int i=0 ; (i<nNodes) ; ++i )
+                branched[i] = branch( level[i].first, level[i].second, (nThreads>1) );
+        }
+        else
+        {
+            // nodes of one level share no state, each one is
+            // scanned by a single thread using its own scratch data
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+            for ( int i=0 ; i<nNodes ; ++i )
+                branched[i] = branch( level[i].first, level[i].second, false );
         }
-    }
-    
-    res->computeCost();
-    
-    const double secs = ((double)clock()-(double)start) / ((double)CLOCKS_PER_SEC);
-    cout << "solution of cost " << res->cost() << " generated in " << secs << " seconds" << endl << endl;
 
-    return res;
-}
+        vector< pair< GNode *, Node *> > nextLevel;
+        for ( int i=0 ; (i<nNodes) ; ++i )
+        {
+            GNode *gn = level[i].first;
+            if (branched[i])
+            {
+                Node *node = level[i].second;
+                if (gn->child[0])
+                {
+                    nextLevel.push_back( make_pair( gn->child[0], node->child()[0]) );
+                    nextLevel.push_back( make_pair( gn->child[1], node->child()[1]) );
+                }
+
+                res->addNode(node->child()[0]);
+                res->addNode(node->child()[1]);
+            }
+            delete gn;
+        }
 
-bool compElVal(const ElVal &lhs, const ElVal &rhs) { return lhs.val < rhs.val; }
+        level.swap( nextLevel );
+    }
+}
 
-void Greedy::prepareBranch( size_t n, size_t f )
+bool Greedy::branch( GNode *gn, Node *node, bool parallelFeatures )
 {
-    GNodeData *gnd = ndata[n];
+    if (nBins)
+        return branchBins( gn, node, parallelFeatures );
 
-    gnd->nElLeft = 0;
-    gnd->idxFeature = f;
+    const SplitInfo *bestSplit = nullptr;
+    const int nFeatures = (int)iset_->features().size();
 
-    if (gnd->idx==0)
+    if (parallelFeatures)
     {
-        // root node
-        for ( size_t i=0 ; (i<rset_->algsettings().size()) ; ++i )
-            gnd->sumResR[i] = rset_->results().sum()[i];
-        for ( size_t i=0 ; (i<rset_->algsettings().size()) ; ++i )
-            gnd->sumResL[i] = 0.0;
+        for ( int it=0 ; (it<nThreads) ; ++it )
+            wdata[it]->bestSplit = SplitInfo();
 
+        // each thread scans a subset of features using its own scratch data
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+        for ( int idxFeature=0 ; idxFeature<nFeatures ; ++idxFeature )
+        {
+#ifdef _OPENMP
+            GNodeData *wnd = wdata[omp_get_thread_num()];
+#else
+            GNodeData *wnd = wdata[0];
+#endif
+            if (useFeature.size() && !useFeature[idxFeature])
+                continue;
+            prepareBranch( wnd, gn, idxFeature );
+            scanFeature( wnd );
+        }
+
+        // deterministic reduction: cheapest split, smallest feature priority on ties
+        const GNodeData *wd0 = wdata[0];
+        bestSplit = &wdata[0]->bestSplit;
+        for ( int it=1 ; (it<nThreads) ; ++it )
+        {
+            const SplitInfo *bs = &wdata[it]->bestSplit;
+            if ( bs->splitCost<bestSplit->splitCost ||
+                 (bs->splitCost==bestSplit->splitCost && wd0->tieKey(bs->idxFeature)<wd0->tieKey(bestSplit->idxFeature)) )
+                bestSplit = bs;
+        }
     }
     else
     {
-        size_t parent = (((int)n)-1)/2;
-        bool isLeft = (n%2);
-        const long double *srp = (isLeft) ? ndata[parent]->sumResL : ndata[parent]->sumResR;
-        memcpy( gnd->sumResR, srp, sizeof(long double)*rset_->algsettings().size() );
-        for ( size_t i=0 ; (i<rset_->algsettings().size() ) ; ++i )
-            gnd->sumResL[i] = 0.0;
+#ifdef _OPENMP
+        GNodeData *wnd = wdata[(nThreads>1) ? omp_get_thread_num() : 0];
+#else
+        GNodeData *wnd = wdata[0];
+#endif
+        wnd->bestSplit = SplitInfo();
+        for ( int idxFeature=0 ; (idxFeature<nFeatures) ; ++idxFeature )
+        {
+            if (useFeature.size() && !useFeature[idxFeature])
+                continue;
+            prepareBranch( wnd, gn, idxFeature );
+            scanFeature( wnd );
+        }
+        bestSplit = &wnd->bestSplit;
     }
 
-    for ( int i=0 ; (i<gnd->nEl) ; ++i )
-        gnd->elv[i].val = iset_->instance(gnd->elv[i].el).float_feature(f);
-    
-    std::sort( gnd->elv, gnd->elv+gnd->nEl, compElVal );
+    // no valid branch
+    if (bestSplit->idxFeature == numeric_limits<size_t>::max())
+        return false;
+
+    // rebuilds the partition from the sorted order of the best feature
+    const size_t bestF = bestSplit->idxFeature;
+    const int nElLeft = bestSplit->nElLeft;
+    if (gn->depth+1<nLevels)
+    {
+        const size_t nAlgs = rset_->algsettings().size();
+        const int *ord = sorted[gn->depth%2] + bestF*((size_t)iset_->size()) + gn->start;
+
+        GNode *left = new GNode( gn->depth+1, gn->start, nElLeft, nAlgs );
+        GNode *right = new GNode( gn->depth+1, gn->start+nElLeft, gn->nEl-nElLeft, nAlgs );
+        std::fill( left->sumRes, left->sumRes+nAlgs, 0.0 );
+        for ( int i=0 ; (i<nElLeft) ; ++i )
+            split_kernel_add( left->sumRes, rset_->resInst(ord[i]), nAlgs );
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            right->sumRes[ia] = gn->sumRes[ia] - left->sumRes[ia];
+        gn->child[0] = left;
+        gn->child[1] = right;
+
+        for ( int i=0 ; (i<gn->nEl) ; ++i )
+            toLeft[ord[i]] = (i<nElLeft);
+        partitionOrders( gn, nElLeft, nFeatures );
+    }
+
+    node->branchOnVal( bestF, bestSplit->cutValue );
+
+    return true;
+}
+
+bool Greedy::branchBins( GNode *gn, Node *node, bool parallelFeatures )
+{
+    const size_t nAlgs = rset_->algsettings().size();
+    const int nFeatures = (int)iset_->features().size();
+    const int nThr = parallelFeatures ? nThreads : 1;
+
+    if (gn->hist == nullptr)
+        buildHist( gn, nThr );
+
+    // best border of each feature
+    vector< double > costF( nFeatures, DBL_MAX );
+    vector< int > binF( nFeatures, -1 );
+
+    // scratch of this thread, when scanning features sequentially
+#ifdef _OPENMP
+    double *ownSumL = wdata[(nThreads>1) ? omp_get_thread_num() : 0]->sumResL;
+#else
+    double *ownSumL = wdata[0]->sumResL;
+#endif
+
+#pragma omp parallel for num_threads(nThr) schedule(dynamic)
+    for ( int f=0 ; f<nFeatures ; ++f )
+    {
+#ifdef _OPENMP
+        double *sumL = parallelFeatures ? wdata[omp_get_thread_num()]->sumResL : ownSumL;
+#else
+        double *sumL = ownSumL;
+#endif
+        if (useFeature.size() && !useFeature[f])
+            continue;
+        std::fill( sumL, sumL+nAlgs, 0.0 );
+        int nLeft = 0;
+        for ( size_t b=binStart[f] ; (b+1<binStart[f+1]) ; ++b )
+        {
+            if (gn->histCnt[b]==0)
+                continue;
+
+            split_kernel_add( sumL, gn->hist + b*nAlgs, nAlgs );
+            nLeft += gn->histCnt[b];
+
+            if (nLeft<minElementsBranch)
+                continue;
+            if (gn->nEl-nLeft<minElementsBranch)
+                break;
+
+            double costL = DBL_MAX, costR = DBL_MAX;
+            split_kernel_min_lr( sumL, gn->sumRes, nAlgs, &costL, &costR );
+            if (costL+costR<costF[f])
+            {
+                costF[f] = costL+costR;
+                binF[f] = (int)(b-binStart[f]);
+            }
+        }
+    }
 
+    int bestF = -1;
+    for ( int f=0 ; (f<nFeatures) ; ++f )
+        if (binF[f]>=0 && (bestF==-1 || costF[f]<costF[bestF] ||
+                (costF[f]==costF[bestF] && wdata[0]->tieKey(f)<wdata[0]->tieKey(bestF))))
+            bestF = f;
+
+    // no valid branch
+    if (bestF == -1)
+        return false;
+
+    const int bestBin = binF[bestF];
+
+    if (gn->depth+1<nLevels)
+    {
+        // children will also be branched: partitions their elements
+        // and builds the histogram of the smaller one, the histogram
+        // of the larger one is the parent minus its sibling
+        int nElLeft = 0;
+        for ( size_t b=binStart[bestF] ; (b<=binStart[bestF]+bestBin) ; ++b )
+            nElLeft += gn->histCnt[b];
+
+        GNode *left = new GNode( gn->depth+1, gn->start, nElLeft, nAlgs );
+        GNode *right = new GNode( gn->depth+1, gn->start+nElLeft, gn->nEl-nElLeft, nAlgs );
+        std::fill( left->sumRes, left->sumRes+nAlgs, 0.0 );
+        for ( size_t b=binStart[bestF] ; (b<=binStart[bestF]+bestBin) ; ++b )
+            split_kernel_add( left->sumRes, gn->hist + b*nAlgs, nAlgs );
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            right->sumRes[ia] = gn->sumRes[ia] - left->sumRes[ia];
+        gn->child[0] = left;
+        gn->child[1] = right;
+
+        const int *el = sorted[gn->depth%2] + gn->start;
+        for ( int i=0 ; (i<gn->nEl) ; ++i )
+            toLeft[el[i]] = (iset_->binInstFeature(el[i], bestF)<=bestBin);
+        partitionOrders( gn, nElLeft, 1 );
+
+        GNode *small = left, *large = right;
+        if (left->nEl > right->nEl)
+            std::swap( small, large );
+
+        buildHist( small, nThr );
+
+        large->hist = gn->hist;
+        large->histCnt = gn->histCnt;
+        gn->hist = nullptr;
+        gn->histCnt = nullptr;
+        split_kernel_sub( large->hist, small->hist, nBins*nAlgs );
+        for ( size_t b=0 ; (b<nBins) ; ++b )
+            large->histCnt[b] -= small->histCnt[b];
+    }
+
+    node->branchOnVal( bestF, iset_->binMaxValue(bestF, bestBin) );
+
+    return true;
+}
+
+void Greedy::buildHist( GNode *gn, int nThr )
+{
+    const size_t nAlgs = rset_->algsettings().size();
+    const int nFeatures = (int)iset_->features().size();
+
+    if (gn->hist == nullptr)
+    {
+        gn->hist = new double[nBins*nAlgs];
+        gn->histCnt = new int[nBins];
+    }
+
+    // elements of the node
+    const int *el = sorted[gn->depth%2] + gn->start;
+
+#pragma omp parallel for num_threads(nThr) schedule(dynamic)
+    for ( int f=0 ; f<nFeatures ; ++f )
+    {
+        double *h = gn->hist + binStart[f]*nAlgs;
+        int *hc = gn->histCnt + binStart[f];
+        std::fill( h, h + (binStart[f+1]-binStart[f])*nAlgs, 0.0 );
+        std::fill( hc, hc + (binStart[f+1]-binStart[f]), 0 );
+        for ( int i=0 ; (i<gn->nEl) ; ++i )
+        {
+            const int b = iset_->binInstFeature( el[i], f );
+            split_kernel_add( h + b*nAlgs, rset_->resInst(el[i]), nAlgs );
+            hc[b]++;
+        }
+    }
+}
+
+void Greedy::prepareBranch( GNodeData *gnd, const GNode *gn, size_t f )
+{
+    gnd->depth = gn->depth;
+    gnd->start = gn->start;
+    gnd->nEl = gn->nEl;
+    gnd->sumRes = gn->sumRes;
     gnd->nElLeft = 0;
+    gnd->idxFeature = f;
+
+    for ( size_t i=0 ; (i<rset_->algsettings().size() ) ; ++i )
+        gnd->sumResL[i] = 0.0;
+
+    // elements already sorted by the value of f
+    const int *ord = sorted[gn->depth%2] + f*((size_t)iset_->size()) + gn->start;
+    for ( int i=0 ; (i<gnd->nEl) ; ++i )
+    {
+        gnd->elv[i].el = ord[i];
+        gnd->elv[i].val = iset_->instance(ord[i]).float_feature(f);
+    }
+
 #ifdef DEBUG
     {
         set< size_t > sEl;
@@ -312,9 +845,192 @@ void Greedy::prepareBranch( size_t n, size_t f )
 #endif
 }
 
+void Greedy::scanFeature( GNodeData *gnd )
+{
+    if (instAlgs)
+        gnd->scanPruned( instAlgs, Parameters::greedyCandAlgs );
+    else
+    {
+        while (gnd->next())
+            gnd->updateBestAlg();
+    }
+}
+
+void Greedy::partitionOrders( const GNode *gn, int nElLeft, size_t nFeatures )
+{
+    // stable partition of the sorted orders of
+    // each feature to the next level
+    const size_t nInsts = iset_->size();
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+    {
+        const int *src = sorted[gn->depth%2] + f*nInsts + gn->start;
+        int *dstL = sorted[(gn->depth+1)%2] + f*nInsts + gn->start;
+        int *dstR = dstL + nElLeft;
+        for ( int i=0 ; (i<gn->nEl) ; ++i )
+        {
+            if (toLeft[src[i]])
+                *(dstL++) = src[i];
+            else
+                *(dstR++) = src[i];
+        }
+    }
+}
+
+void Greedy::setRandomization( unsigned int seed, double featPerc )
+{
+    const size_t nFeatures = iset_->features().size();
+    std::mt19937 rng( seed );
+
+    featPrio = vector< int >( nFeatures );
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+        featPrio[f] = (int)f;
+    std::shuffle( featPrio.begin(), featPrio.end(), rng );
+
+    // features with the featPerc smallest priorities are used
+    const size_t nUsed = std::max( (size_t)1, (size_t)ceil(featPerc*nFeatures) );
+    useFeature = vector< char >( nFeatures );
+    for ( size_t f=0 ; (f<nFeatures) ; ++f )
+        useFeature[f] = ((size_t)featPrio[f]<nUsed);
+
+    for ( int i=0 ; (i<nThreads) ; ++i )
+        wdata[i]->featPrio = &featPrio[0];
+}
+
+void Greedy::clearRandomization()
+{
+    featPrio.clear();
+    useFeature.clear();
+    for ( int i=0 ; (i<nThreads) ; ++i )
+        wdata[i]->featPrio = nullptr;
+}
+
+void Greedy::setMinElementsBranch( int minEl )
+{
+    minElementsBranch = minEl;
+    for ( int i=0 ; (i<nThreads) ; ++i )
+        wdata[i]->minEl = minEl;
+}
+
+// sum over the leafs in the subtree of node of the results, in the
+// evaluation the greedy optimizes (-eval), of the best algorithm of each leaf
+static long double resCostSubtree( const Node *node, const ResultsSet *rset )
+{
+    if (node->branchFeature()!=numeric_limits<size_t>::max())
+        return resCostSubtree( node->ichild(0), rset ) + resCostSubtree( node->ichild(1), rset );
+
+    const size_t nAlgs = rset->algsettings().size();
+    vector< long double > sumAlg( nAlgs, 0.0 );
+    for ( size_t ie=0 ; (ie<node->n_elements()) ; ++ie )
+        for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
+            sumAlg[idxAlg] += rset->res( node->elements()[ie], idxAlg );
+
+    return *min_element( sumAlg.begin(), sumAlg.end() );
+}
+
+double Greedy::resCost( const Tree *tree ) const
+{
+    return (double)( resCostSubtree( tree->root(), rset_ ) / (long double)iset_->size() );
+}
+
+vector< Tree * > Greedy::buildPortfolio( Tree *tree, int nTrees, int nBest )
+{
+    const auto start = std::chrono::steady_clock::now();
+    const int minEl = minElementsBranch;
+    nBest = std::max( 1, nBest );
+
+    // settings of each tree drawn in advance, so
+    // that trees do not depend on the threads
+    std::mt19937 rng( 1 );
+    std::uniform_real_distribution< double > uFeat( 0.5, 1.0 );
+    std::uniform_real_distribution< double > uMinEl( 1.0, 1.5 );
+    vector< double > featPerc( nTrees+1 );
+    vector< int > minElT( nTrees+1 );
+    for ( int t=1 ; (t<=nTrees) ; ++t )
+    {
+        featPerc[t] = uFeat(rng);
+        // minElementsBranch only increases, so that
+        // trees remain valid for the exact solvers
+        minElT[t] = (int)ceil( minEl*uMinEl(rng) );
+    }
+
+    int nThr = 1;
+#ifdef _OPENMP
+    nThr = std::min( nTrees, (Parameters::threads>=1) ? Parameters::threads : omp_get_num_procs() );
+#endif
+
+    // trees ranked by cost and then by seed, the initial tree has seed 0
+    typedef std::tuple< double, int, Tree * > RankedTree;
+    auto keepBest = [nBest]( vector< RankedTree > &best, const RankedTree &rt ) {
+        best.insert( std::upper_bound( best.begin(), best.end(), rt,
+                    []( const RankedTree &x, const RankedTree &y ) {
+                        return std::make_pair( std::get<0>(x), std::get<1>(x) ) <
+                            std::make_pair( std::get<0>(y), std::get<1>(y) ); } ), rt );
+        if ((int)best.size()>nBest)
+        {
+            delete std::get<2>( best.back() );
+            best.pop_back();
+        }
+    };
+
+    // nBest cheapest trees built by each thread
+    vector< vector< RankedTree > > thrBest( nThr );
+
+#pragma omp parallel num_threads(nThr)
+    {
+#ifdef _OPENMP
+        const int it = omp_get_thread_num();
+#else
+        const int it = 0;
+#endif
+        Greedy grd( iset_, rset_ );
+#pragma omp for schedule(dynamic)
+        for ( int t=1 ; t<=nTrees ; ++t )
+        {
+            grd.setRandomization( t, featPerc[t] );
+            grd.setMinElementsBranch( minElT[t] );
+
+            Tree *rt = grd.buildTree();
+            keepBest( thrBest[it], RankedTree( resCost( rt ), t, rt ) );
+        }
+    }
+
+    vector< RankedTree > best;
+    keepBest( best, RankedTree( resCost( tree ), 0, tree ) );
+    for ( const auto &tb : thrBest )
+        for ( const auto &rt : tb )
+            keepBest( best, rt );
+
+    const double secs = std::chrono::duration< double >( std::chrono::steady_clock::now()-start ).count();
+    cout << nTrees << " randomized greedy trees built in " << secs << " seconds using " << nThr <<
+        " threads, best tree of cost " << std::get<2>( best[0] )->cost() << " (evaluation " << std::get<0>( best[0] ) << ")";
+    if (std::get<1>( best[0] ))
+        cout << " is the randomized tree " << std::get<1>( best[0] ) << endl;
+    else
+        cout << " is the initial one" << endl;
+    if (best.size()>1)
+    {
+        cout << best.size() << " cheapest trees:";
+        for ( const auto &rt : best )
+            cout << " " << std::get<1>( rt ) << " (" << std::get<0>( rt ) << ")";
+        cout << endl;
+    }
+    cout << endl;
+
+    vector< Tree * > res;
+    for ( const auto &rt : best )
+        res.push_back( std::get<2>( rt ) );
+
+    return res;
+}
+
 Greedy::~Greedy ()
 {
-    for ( size_t i=0 ; (i<tnodes) ; ++i )
-        delete ndata[i];
-    delete[] ndata;
+    delete[] sorted[0];
+    delete[] sorted;
+    delete[] toLeft;
+    delete[] instAlgs;
+
+    for ( int i=0 ; (i<nThreads) ; ++i )
+        delete wdata[i];
+    delete[] wdata;
 }
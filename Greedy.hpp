@@ -11,9 +11,12 @@
 class InstanceSet;
 class ResultsSet;
 class Tree;
+class Node;
 class GNodeData;
+class GNode;
 
 #include <cstddef>
+#include <vector>
 
 class Greedy
 {
@@ -22,18 +25,100 @@ public:
 
     Tree *build();
 
+    // branches leaf node of tree using only its instances, adding
+    // the nodes of its subtree, down to maxDepth, to tree
+    void expandNode( Tree *tree, Node *node );
+
+    // following trees are built using only a random subset with
+    // featPerc of the features and breaking ties randomly
+    void setRandomization( unsigned int seed, double featPerc );
+    void clearRandomization();
+
+    // builds nTrees randomized trees concurrently, with random subsets
+    // of features, tie breaking and larger minElementsBranch. returns
+    // the nBest cheapest ones among them and tree, cheapest first, the
+    // other ones are deleted. trees are ranked by resCost, ties are
+    // broken by the smallest seed, tree first
+    std::vector< Tree * > buildPortfolio( Tree *tree, int nTrees, int nBest = 1 );
+
+    // average cost of tree in the evaluation optimized by the greedy
+    // and the MIP (-eval), the best algorithm of each leaf selected by
+    // it. Tree::cost() is the average of the original results instead
+    double resCost( const Tree *tree ) const;
+
     virtual ~Greedy ();
 private:
     const InstanceSet *iset_;
     const ResultsSet *rset_;
 
-    // prepare for branching on node and feature
-    void prepareBranch( size_t n, size_t f );
+    // build without messages
+    Tree *buildTree();
+
+    // branches groot and its descendants, node of res, until
+    // no valid branch exists or the last level is reached
+    void grow( Tree *res, Node *root, GNode *groot );
+
+    // builds the tree one level at a time, expanding
+    // all nodes of a level concurrently
+    void buildLevels( Tree *res, Node *root, GNode *groot );
+
+    // searches the best branch for gn and, if some valid
+    // branch is found, branches node, returning true
+    bool branch( GNode *gn, Node *node, bool parallelFeatures );
+
+    // branch considering only the borders of feature bins
+    bool branchBins( GNode *gn, Node *node, bool parallelFeatures );
+
+    // computes the histogram of gn
+    void buildHist( GNode *gn, int nThr );
+
+    // prepare gnd for branching on node gn and feature f
+    void prepareBranch( GNodeData *gnd, const GNode *gn, size_t f );
 
+    // evaluates all cuts of the feature prepared in gnd
+    void scanFeature( GNodeData *gnd );
+
+    // fills the sorted orders of the first nFeatures features
+    // of the children of gn, which was just branched with
+    // nElLeft elements in the left, according to toLeft
+    void partitionOrders( const GNode *gn, int nElLeft, size_t nFeatures );
 
-    GNodeData **ndata;
-    size_t tnodes; // total nodes in full btree
     size_t maxDepth;
+
+    // number of levels where nodes can be branched
+    size_t nLevels;
+
+    // instances sorted by each feature value, in two buffers
+    // used by even and odd levels: each node is a range
+    int **sorted;
+
+    // which instances go to the left child
+    bool *toLeft;
+
+    // threads used to scan features
+    int nThreads;
+
+    // scan data of each thread
+    GNodeData **wdata;
+
+    // total number of bins and first bin of each
+    // feature, when branching on bins
+    size_t nBins;
+    std::vector< size_t > binStart;
+
+    // minimum number of elements in each child, starts as
+    // Parameters::minElementsBranch
+    int minElementsBranch;
+    void setMinElementsBranch( int minEl );
+
+    // when scanning features with candidate algorithms,
+    // the greedyCandAlgs+1 cheapest algorithms of each instance
+    int *instAlgs;
+
+    // when randomized: priority of each feature in
+    // ties and features which can be used
+    std::vector< int > featPrio;
+    std::vector< char > useFeature;
 };
 
 #endif /* GREEDY_HPP_ */
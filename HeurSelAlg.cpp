@@ -0,0 +1,462 @@
+/*
+ * HeurSelAlg.cpp
+ */
+
+#include "HeurSelAlg.hpp"
+#include "Parameters.hpp"
+#include "ResultsSet.hpp"
+#include "InstanceSet.hpp"
+#include "pdtdefines.hpp"
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cassert>
+#include <omp.h>
+
+using namespace std;
+
+// candidates, the not selected algorithms with the largest gains,
+// tried in repair to replace each algorithm with deficit
+static const int maxRepairCand = 50;
+
+// inserts algorithm a with result r in the sorted list of size T
+static void insertTop( int *alg, double *res, int T, int a, double r )
+{
+    if (r>=res[T-1])
+        return;
+
+    int j = T-1;
+    while (j>0 && res[j-1]>r)
+    {
+        res[j] = res[j-1];
+        alg[j] = alg[j-1];
+        --j;
+    }
+    res[j] = r;
+    alg[j] = a;
+}
+
+// if swap (a1, r1) is better than (a2, r2): ties are broken by
+// indexes, so that the result does not depend on the threads
+static bool betterSwap( double d1, int a1, int r1, double d2, int a2, int r2 )
+{
+    if (d1!=d2)
+        return d1<d2;
+    if (a1!=a2)
+        return a1<a2;
+    return r1<r2;
+}
+
+HeurSelAlg::HeurSelAlg( const ResultsSet *_rset ) :
+    rset_(_rset),
+    iset_(&rset_->instanceSet()),
+    nAlgs(_rset->algsettings().size()),
+    K(std::max( 1, Parameters::afMinAlgsInst )),
+    nThreads((Parameters::threads>=1) ? Parameters::threads : omp_get_num_procs()),
+    nSelAlg_(0),
+    selAlg_(new int[_rset->algsettings().size()]),
+    inS(_rset->algsettings().size(), 0)
+{
+    for ( int i=0 ; (i<iset_->size()) ; ++i )
+        if (rset_->stdDevInst(i)>MIN_STD_DEV)
+            insts.push_back( i );
+
+    for ( size_t a=0 ; (a<nAlgs) ; ++a )
+        algCost.push_back( ((double)Parameters::minElementsBranch)*rset_->avAlg(a) );
+
+    const size_t T = K+1;
+    topAlg = vector< int >( insts.size()*T, -1 );
+    topRes = vector< double >( insts.size()*T );
+    for ( size_t p=0 ; (p<insts.size()) ; ++p )
+    {
+        const double *r = rset_->resInst(insts[p]);
+        maxRes.push_back( *max_element( r, r+nAlgs ) );
+        std::fill( topRes.begin()+p*T, topRes.begin()+(p+1)*T, maxRes.back() );
+    }
+}
+
+double HeurSelAlg::cost() const
+{
+    double res = 0.0;
+    for ( int i=0 ; (i<nSelAlg_) ; ++i )
+        res += algCost[selAlg_[i]];
+    for ( size_t p=0 ; (p<insts.size()) ; ++p )
+        for ( int j=0 ; (j<K) ; ++j )
+            res += topRes[p*(K+1)+j];
+
+    return res;
+}
+
+void HeurSelAlg::addAlg( int a )
+{
+    assert( !inS[a] );
+    inS[a] = 1;
+    selAlg_[nSelAlg_++] = a;
+
+    const int T = K+1;
+#pragma omp parallel for num_threads(nThreads)
+    for ( int p=0 ; p<(int)insts.size() ; ++p )
+        insertTop( &topAlg[p*T], &topRes[p*T], T, a, rset_->resInst(insts[p])[a] );
+}
+
+void HeurSelAlg::removeAlg( int r )
+{
+    assert( inS[r] );
+    inS[r] = 0;
+    int *pos = std::find( selAlg_, selAlg_+nSelAlg_, r );
+    *pos = selAlg_[--nSelAlg_];
+
+    const int T = K+1;
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic, 64)
+    for ( int p=0 ; p<(int)insts.size() ; ++p )
+        if (std::find( &topAlg[p*T], &topAlg[p*T]+T, r ) != &topAlg[p*T]+T)
+            rebuildTop( p );
+}
+
+void HeurSelAlg::rebuildTop( size_t p )
+{
+    const int T = K+1;
+    int *alg = &topAlg[p*T];
+    double *res = &topRes[p*T];
+    std::fill( alg, alg+T, -1 );
+    std::fill( res, res+T, maxRes[p] );
+    const double *r = rset_->resInst(insts[p]);
+    for ( int i=0 ; (i<nSelAlg_) ; ++i )
+        insertTop( alg, res, T, selAlg_[i], r[selAlg_[i]] );
+}
+
+double HeurSelAlg::addGain( int a ) const
+{
+    const int T = K+1;
+    double gain = -algCost[a];
+    for ( size_t p=0 ; (p<insts.size()) ; ++p )
+        gain += std::max( 0.0, topRes[p*T+K-1] - rset_->resInst(insts[p])[a] );
+
+    return gain;
+}
+
+void HeurSelAlg::construct()
+{
+    const int nSel = std::min( Parameters::maxAlgs, (int)nAlgs );
+
+    vector< double > gain( nAlgs );
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+    for ( int a=0 ; a<(int)nAlgs ; ++a )
+        gain[a] = addGain( a );
+
+    // gains only decrease when algorithms are added: the gain in
+    // the queue is an upper bound, recomputed when it is on top
+    priority_queue< pair< double, int > > queue;
+    vector< int > evalAt( nAlgs, 0 );
+    for ( size_t a=0 ; (a<nAlgs) ; ++a )
+        queue.push( make_pair( gain[a], -((int)a) ) );
+
+    while (nSelAlg_<nSel && queue.size())
+    {
+        const int a = -queue.top().second;
+        queue.pop();
+        if (evalAt[a]==nSelAlg_)
+        {
+            // an algorithm which is not among the K cheapest ones of
+            // enough instances will not be after more are selected
+            addAlg( a );
+            if (deficit()>0)
+                removeAlg( a );
+            continue;
+        }
+        evalAt[a] = nSelAlg_;
+        queue.push( make_pair( addGain( a ), -a ) );
+    }
+
+    // no algorithm can be added keeping the selection feasible:
+    // the remaining ones are the ones with largest gains
+    while (nSelAlg_<nSel)
+    {
+        int best = -1;
+        double bestGain = -DBL_MAX;
+        for ( int a=0 ; (a<(int)nAlgs) ; ++a )
+        {
+            if (inS[a])
+                continue;
+            const double g = addGain( a );
+            if (g>bestGain)
+            {
+                bestGain = g;
+                best = a;
+            }
+        }
+        addAlg( best );
+    }
+}
+
+int HeurSelAlg::deficit() const
+{
+    vector< int > nInstAlg( nAlgs, 0 );
+    for ( size_t p=0 ; (p<insts.size()) ; ++p )
+        for ( int j=0 ; (j<K) ; ++j )
+            if (topAlg[p*(K+1)+j]>=0)
+                ++nInstAlg[topAlg[p*(K+1)+j]];
+
+    int res = 0;
+    for ( int i=0 ; (i<nSelAlg_) ; ++i )
+        res += std::max( 0, Parameters::minElementsBranch-nInstAlg[selAlg_[i]] );
+
+    return res;
+}
+
+int HeurSelAlg::repair( double deadline )
+{
+    int def = deficit();
+    while (def>0 && omp_get_wtime()<deadline)
+    {
+        vector< int > nInstAlg( nAlgs, 0 );
+        for ( size_t p=0 ; (p<insts.size()) ; ++p )
+            for ( int j=0 ; (j<K) ; ++j )
+                if (topAlg[p*(K+1)+j]>=0)
+                    ++nInstAlg[topAlg[p*(K+1)+j]];
+
+        // algorithms with the largest deficits are replaced first,
+        // by the not selected ones with the largest gains
+        vector< int > viol, cand;
+        for ( int i=0 ; (i<nSelAlg_) ; ++i )
+            if (nInstAlg[selAlg_[i]]<Parameters::minElementsBranch)
+                viol.push_back( selAlg_[i] );
+        std::sort( viol.begin(), viol.end(), [&] ( int a1, int a2 ) {
+            return nInstAlg[a1]<nInstAlg[a2] || (nInstAlg[a1]==nInstAlg[a2] && a1<a2); } );
+
+        vector< double > gain( nAlgs, -DBL_MAX );
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+        for ( int a=0 ; a<(int)nAlgs ; ++a )
+            if (!inS[a])
+                gain[a] = addGain( a );
+        for ( int a=0 ; (a<(int)nAlgs) ; ++a )
+            if (!inS[a])
+                cand.push_back( a );
+        const size_t nCand = std::min( cand.size(), (size_t)maxRepairCand );
+        std::partial_sort( cand.begin(), cand.begin()+nCand, cand.end(), [&] ( int a1, int a2 ) {
+            return gain[a1]>gain[a2] || (gain[a1]==gain[a2] && a1<a2); } );
+        cand.resize( nCand );
+
+        bool improved = false;
+        for ( size_t i=0 ; (i<viol.size() && !improved && omp_get_wtime()<deadline) ; ++i )
+        {
+            const int r = viol[i];
+            for ( const auto a : cand )
+            {
+                removeAlg( r );
+                addAlg( a );
+                const int d = deficit();
+                if (d<def)
+                {
+                    def = d;
+                    improved = true;
+                    break;
+                }
+                removeAlg( a );
+                addAlg( r );
+            }
+        }
+        if (!improved)
+            break;
+    }
+
+    return def;
+}
+
+vector< HeurSelAlg::Swap > HeurSelAlg::improvingSwaps( double minDecrease ) const
+{
+    const int T = K+1;
+    vector< vector< Swap > > thrSwaps( nThreads );
+
+#pragma omp parallel num_threads(nThreads)
+    {
+        const int t = omp_get_thread_num();
+        // change in cost when each selected algorithm is removed
+        vector< double > corr( nAlgs, 0.0 );
+#pragma omp for schedule(dynamic)
+        for ( int a=0 ; a<(int)nAlgs ; ++a )
+        {
+            if (inS[a])
+                continue;
+
+            // adding a: the K-th algorithm of an instance is replaced if a
+            // is cheaper. if r is also removed and was one of the K
+            // cheapest, the (K+1)-th one is the K-th one when a is added
+            double base = 0.0;
+            for ( size_t p=0 ; (p<insts.size()) ; ++p )
+            {
+                const int *ta = &topAlg[p*T];
+                const double *tr = &topRes[p*T];
+                const double ra = rset_->resInst(insts[p])[a];
+                const double gain = std::max( 0.0, tr[K-1]-ra );
+                const double gain1 = std::max( 0.0, tr[K]-ra );
+                base -= gain;
+                for ( int j=0 ; (j<K) ; ++j )
+                    if (ta[j]>=0)
+                        corr[ta[j]] += tr[K] - tr[j] - gain1 + gain;
+            }
+
+            for ( int i=0 ; (i<nSelAlg_) ; ++i )
+            {
+                const int r = selAlg_[i];
+                const double delta = base + corr[r] + algCost[a] - algCost[r];
+                corr[r] = 0.0;
+                if (delta<-minDecrease)
+                    thrSwaps[t].push_back( Swap{ delta, a, r } );
+            }
+        }
+    }
+
+    vector< Swap > res;
+    for ( const auto &ts : thrSwaps )
+        res.insert( res.end(), ts.begin(), ts.end() );
+    std::sort( res.begin(), res.end(), [] ( const Swap &s1, const Swap &s2 ) {
+        return betterSwap( s1.delta, s1.a, s1.r, s2.delta, s2.a, s2.r ); } );
+
+    return res;
+}
+
+double HeurSelAlg::lagrangeanBound( double ub, double maxSeconds ) const
+{
+    // relaxing the constraints which select at least K algorithms
+    // per instance: algorithms with the smallest reduced costs are
+    // selected, the ones of each instance cheaper than its multiplier
+    const double startT = omp_get_wtime();
+    const size_t n = insts.size();
+    const int nSel = nSelAlg_;
+
+    vector< double > lambda( n );
+    for ( size_t p=0 ; (p<n) ; ++p )
+    {
+        vector< double > r( rset_->resInst(insts[p]), rset_->resInst(insts[p])+nAlgs );
+        std::nth_element( r.begin(), r.begin()+std::min( K-1, (int)nAlgs-1 ), r.end() );
+        lambda[p] = std::max( 0.0, r[std::min( K-1, (int)nAlgs-1 )] );
+    }
+
+    double best = -DBL_MAX, theta = 2.0;
+    int noImprov = 0;
+    vector< double > rho( nAlgs );
+    vector< int > ord( nAlgs );
+    vector< double > subg( n );
+    for ( int it=0 ; (it<Parameters::selAlgLagIt && omp_get_wtime()-startT<maxSeconds) ; ++it )
+    {
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+        for ( int a=0 ; a<(int)nAlgs ; ++a )
+        {
+            double r = algCost[a];
+            for ( size_t p=0 ; (p<n) ; ++p )
+                r += std::min( 0.0, rset_->resInst(insts[p])[a] - lambda[p] );
+            rho[a] = r;
+        }
+
+        std::iota( ord.begin(), ord.end(), 0 );
+        std::nth_element( ord.begin(), ord.begin()+nSel-1, ord.end(),
+                [&] ( int a1, int a2 ) { return rho[a1]<rho[a2] || (rho[a1]==rho[a2] && a1<a2); } );
+
+        double lb = 0.0;
+        for ( size_t p=0 ; (p<n) ; ++p )
+            lb += K*lambda[p];
+        for ( int i=0 ; (i<nSel) ; ++i )
+            lb += rho[ord[i]];
+
+        if (lb>best+1e-9)
+        {
+            best = lb;
+            noImprov = 0;
+        }
+        else if (++noImprov>=20)
+        {
+            theta /= 2.0;
+            noImprov = 0;
+        }
+
+        std::fill( subg.begin(), subg.end(), (double)K );
+        for ( int i=0 ; (i<nSel) ; ++i )
+            for ( size_t p=0 ; (p<n) ; ++p )
+                if (rset_->resInst(insts[p])[ord[i]]<lambda[p])
+                    subg[p] -= 1.0;
+
+        double norm = 0.0;
+        for ( auto g : subg )
+            norm += g*g;
+        if (norm<1e-12)
+            break;
+
+        const double step = theta*(ub-lb)/norm;
+        for ( size_t p=0 ; (p<n) ; ++p )
+            lambda[p] = std::max( 0.0, lambda[p] + step*subg[p] );
+    }
+
+    return best;
+}
+
+void HeurSelAlg::optimize( int maxSeconds )
+{
+    const double startT = omp_get_wtime();
+    construct();
+    int def = repair( startT+maxSeconds );
+
+    double obj = cost();
+    cout << "greedy selection of " << nSelAlg_ << " algorithms with cost " << obj << " in " <<
+        omp_get_wtime()-startT << " seconds" << endl;
+
+    // the change in cost of a swap is computed for all swaps at once,
+    // the deficit only after the swap: swaps which would increase it
+    // are undone and the next best one is tried
+    int nSwaps = 0;
+    bool improved = true;
+    while (improved && omp_get_wtime()-startT<maxSeconds)
+    {
+        improved = false;
+        for ( const auto &sw : improvingSwaps( 1e-9*std::max( 1.0, fabs(obj) ) ) )
+        {
+            if (omp_get_wtime()-startT>=maxSeconds)
+                break;
+
+            removeAlg( sw.r );
+            addAlg( sw.a );
+            const int d = deficit();
+            if (d<=def)
+            {
+                def = d;
+                obj += sw.delta;
+                ++nSwaps;
+                improved = true;
+                break;
+            }
+            removeAlg( sw.a );
+            addAlg( sw.r );
+        }
+    }
+    obj = cost();
+    cout << nSwaps << " swaps, cost " << obj << " in " << omp_get_wtime()-startT << " seconds" << endl;
+
+    if (Parameters::selAlgLagIt>0)
+    {
+        const double lb = lagrangeanBound( obj, std::max( 0.0, maxSeconds-(omp_get_wtime()-startT) ) );
+        cout << "lagrangean lower bound " << lb << ", gap " << 100.0*(obj-lb)/std::max( 1e-9, fabs(obj) ) << "%" << endl;
+    }
+
+    if (def>0)
+        cout << "no feasible selection found: " << def << " instances missing for all selected algorithms to be among the " <<
+            K << " cheapest ones of at least " << Parameters::minElementsBranch << " instances" << endl;
+
+    std::sort( selAlg_, selAlg_+nSelAlg_ );
+}
+
+void HeurSelAlg::saveFilteredResults( const char *fileName ) const
+{
+    rset_->saveFilteredResults( fileName, nSelAlg_, selAlg_ );
+}
+
+HeurSelAlg::~HeurSelAlg ()
+{
+    delete[] selAlg_;
+}
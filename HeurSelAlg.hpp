@@ -0,0 +1,106 @@
+/*
+ * HeurSelAlg.hpp
+ */
+
+#ifndef HEURSELALG_HPP_
+#define HEURSELALG_HPP_
+
+class ResultsSet;
+class InstanceSet;
+
+#include <cstddef>
+#include <vector>
+
+// heuristic for the problem solved by MIPSelAlg, without building
+// the MIP: selects maxAlgs algorithms minimizing their costs plus
+// the sum of the afMinAlgsInst cheapest selected algorithms of each
+// instance. as in the minInstAlg rows of the MIP, each selected
+// algorithm must be among the afMinAlgsInst cheapest ones of at
+// least minElementsBranch instances. a greedy (lazy evaluation)
+// constructive is followed by a swap local search and, optionally,
+// a lagrangean lower bound
+class HeurSelAlg
+{
+public:
+    HeurSelAlg( const ResultsSet *_rset );
+
+    void optimize( int maxSeconds );
+
+    int nSelAlg() const {
+        return nSelAlg_;
+    }
+
+    const int *selAlg() const {
+        return selAlg_;
+    }
+
+    void saveFilteredResults( const char *fileName ) const;
+
+    virtual ~HeurSelAlg ();
+private:
+    const ResultsSet *rset_;
+    const InstanceSet *iset_;
+
+    size_t nAlgs;
+
+    // number of cheapest algorithms paid for each instance
+    int K;
+
+    int nThreads;
+
+    int nSelAlg_;
+    int *selAlg_;
+
+    // instances considered, as in MIPSelAlg
+    std::vector< int > insts;
+
+    // cost of selecting each algorithm
+    std::vector< double > algCost;
+
+    std::vector< char > inS;
+
+    // for each instance, the K+1 cheapest selected algorithms
+    // and their results, in increasing order. empty positions
+    // have algorithm -1 and the largest result of the instance
+    std::vector< int > topAlg;
+    std::vector< double > topRes;
+    std::vector< double > maxRes;
+
+    double cost() const;
+
+    void addAlg( int a );
+    void removeAlg( int r );
+
+    // rebuilds the list of cheapest algorithms of instance at position p
+    void rebuildTop( size_t p );
+
+    // decrease in cost when algorithm a is added
+    double addGain( int a ) const;
+
+    // sum, over the selected algorithms, of the number of instances
+    // missing for them to be among the K cheapest ones of
+    // minElementsBranch instances: 0 for feasible selections
+    int deficit() const;
+
+    // greedy selection of maxAlgs algorithms
+    void construct();
+
+    // swaps out the algorithms with deficit while the deficit
+    // decreases, trying the maxRepairCand not selected algorithms
+    // with the largest gains for each one, until deadline (as
+    // omp_get_wtime). returns the final deficit
+    int repair( double deadline );
+
+    // swaps (add a, remove r) which decrease the cost by more than
+    // minDecrease, with their changes in cost, sorted from the best one
+    struct Swap {
+        double delta;
+        int a;
+        int r;
+    };
+    std::vector< Swap > improvingSwaps( double minDecrease ) const;
+
+    double lagrangeanBound( double ub, double maxSeconds ) const;
+};
+
+#endif /* HEURSELALG_HPP_ */
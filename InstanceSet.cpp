@@ -27,7 +27,9 @@ static std::unordered_set< std::string > check_instances_with_different_results(
 InstanceSet::InstanceSet (const char *fileName, const char *resultsFileName, int ifold, int kfold ) :
     inst_dataset_(new Dataset(fileName)),
     test_dataset_(nullptr),
-    instFeatRank(nullptr)
+    instFeatRank(nullptr),
+    rankGroups_(true),
+    instFeatBin(nullptr)
 {
     if (kfold>=2)
     {
@@ -234,6 +236,94 @@ InstanceSet::InstanceSet (const char *fileName, const char *resultsFileName, int
             instFeatRank[i][f] = itv->second;
         }
     }
+
+    // instances with the same rank in all features
+    {
+        map< vector< int >, int > groupBySign;
+        instGroup_ = vector< int >( instances().size() );
+        for ( int i=0 ; (i<(int)instances().size()) ; ++i )
+        {
+            const vector< int > sign( instFeatRank[i], instFeatRank[i]+features().size() );
+            auto it = groupBySign.find( sign );
+            if (it == groupBySign.end())
+            {
+                it = groupBySign.insert( make_pair( sign, (int)groups_.size() ) ).first;
+                groups_.push_back( vector< int >() );
+            }
+            instGroup_[i] = it->second;
+            groups_[it->second].push_back( i );
+        }
+    }
+
+    instByFeatVal_ = vector< vector< int > >( features().size() );
+    for ( size_t idxF=0 ; (idxF<features().size()) ; ++idxF )
+    {
+        vector< pair< double, int > > instVal;
+        instVal.reserve( instances().size() );
+        for ( int i=0 ; (i<(int)instances().size()) ; ++i )
+            instVal.push_back( make_pair( instance(i).float_feature(idxF), i ) );
+
+        std::sort( instVal.begin(), instVal.end() );
+
+        instByFeatVal_[idxF].reserve( instVal.size() );
+        for ( const auto &iv : instVal )
+            instByFeatVal_[idxF].push_back( iv.second );
+    }
+
+    if (Parameters::greedyBins>0)
+        computeBins( Parameters::greedyBins );
+}
+
+void InstanceSet::computeBins( int maxBins )
+{
+    assert( maxBins>=1 && maxBins<=256 );
+
+    const int nInsts = (int)instances().size();
+    nBinsF_ = vector< int >( features().size(), 0 );
+    binMaxVal_ = vector< vector< double > >( features().size() );
+
+    instFeatBin = new unsigned char*[instances_.size()];
+    instFeatBin[0] = new unsigned char[instances_.size()*features().size()];
+    for ( int i=1 ; (i<nInsts) ; ++i )
+        instFeatBin[i] = instFeatBin[i-1] + features().size();
+
+    for ( size_t idxF=0 ; (idxF<features().size()) ; ++idxF )
+    {
+        // bin of each rank
+        vector< int > rankBin( rankingsF_[idxF] );
+        if (rankingsF_[idxF]<=maxBins)
+        {
+            for ( int r=0 ; (r<rankingsF_[idxF]) ; ++r )
+                rankBin[r] = r;
+            nBinsF_[idxF] = rankingsF_[idxF];
+        }
+        else
+        {
+            // consecutive ranks are merged in bins with
+            // (approximately) the same number of instances
+            const int binSize = (int)ceil( ((double)nInsts) / ((double)maxBins) );
+            int bin = 0, nElBin = 0;
+            for ( int r=0 ; (r<rankingsF_[idxF]) ; ++r )
+            {
+                rankBin[r] = bin;
+                nElBin += nElementsFeatRank_[idxF][r];
+                if (nElBin>=binSize && r+1<rankingsF_[idxF] && bin+1<maxBins)
+                {
+                    ++bin;
+                    nElBin = 0;
+                }
+            }
+            nBinsF_[idxF] = bin+1;
+        }
+
+        binMaxVal_[idxF] = vector< double >( nBinsF_[idxF], -DBL_MAX );
+        for ( int i=0 ; (i<nInsts) ; ++i )
+        {
+            const int bin = rankBin[instFeatRank[i][idxF]];
+            instFeatBin[i][idxF] = (unsigned char)bin;
+            binMaxVal_[idxF][bin] = max( binMaxVal_[idxF][bin], instance(i).float_feature(idxF) );
+        }
+    }
 }
 
 int InstanceSet::size() const
@@ -267,6 +357,15 @@ InstanceSet::types () const
     return this->types_;
 }
 
+void InstanceSet::setGroups( const vector< vector< int > > &groups )
+{
+    groups_ = groups;
+    rankGroups_ = false;
+    for ( size_t g=0 ; (g<groups_.size()) ; ++g )
+        for ( auto i : groups_[g] )
+            instGroup_[i] = g;
+}
+
 InstanceSet::~InstanceSet ()
 {
     if (inst_dataset_)
@@ -277,6 +376,12 @@ InstanceSet::~InstanceSet ()
     delete[] instFeatRank[0];
     delete[] instFeatRank;
 
+    if (instFeatBin)
+    {
+        delete[] instFeatBin[0];
+        delete[] instFeatBin;
+    }
+
     if (test_dataset_)
         delete test_dataset_;
 }
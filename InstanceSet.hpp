@@ -72,6 +72,54 @@ public:
         return nValidBF_[idxF];
     }
 
+    // instances sorted by increasing value of feature idxF
+    // (ties broken by instance index)
+    const std::vector< int > &instancesByFeatureVal( size_t idxF ) const {
+        return instByFeatVal_[idxF];
+    }
+
+    // instances with the same rank in all features are grouped:
+    // no branching can separate them. after setGroups, e.g. with the
+    // groups of a coreset, groups may hold instances of different
+    // ranks. the first instance of each group is its representative,
+    // the one with the smallest index in the rank groups
+    int nGroups() const {
+        return (int)groups_.size();
+    }
+
+    const std::vector< int > &groupInstances( size_t idxGroup ) const {
+        return groups_[idxGroup];
+    }
+
+    int instanceGroup( size_t idxInst ) const {
+        return instGroup_[idxInst];
+    }
+
+    // replaces the groups, e.g. by the ones of a coreset: the first
+    // instance of each group represents it in the MIP models
+    void setGroups( const std::vector< std::vector< int > > &groups );
+
+    // if the groups are the ones of instances with the same ranks,
+    // i.e., setGroups was not called
+    bool rankGroups() const {
+        return rankGroups_;
+    }
+
+    // number of bins of feature idxF, 0 if features were not binned
+    int nBinsFeature( size_t idxF ) const {
+        return nBinsF_.size() ? nBinsF_[idxF] : 0;
+    }
+
+    // bin of feature idxF for instance idxInst
+    int binInstFeature( size_t idxInst, size_t idxF ) const {
+        return instFeatBin[idxInst][idxF];
+    }
+
+    // largest value of feature idxF in bin
+    double binMaxValue( size_t idxF, int bin ) const {
+        return binMaxVal_[idxF][bin];
+    }
+
     virtual ~InstanceSet ();
 
     void save(const char *fileName, bool normalized = true) const;
@@ -102,6 +150,25 @@ private:
 
     int **instFeatRank; // per instance
 
+    // instances sorted by feature value, per feature
+    std::vector< std::vector< int > > instByFeatVal_;
+
+    // groups of instances with the same feature ranks, unless
+    // replaced by setGroups
+    std::vector< std::vector< int > > groups_;
+    std::vector< int > instGroup_;
+    bool rankGroups_;
+
+    // quantizes each feature in at most maxBins bins,
+    // merging consecutive ranks
+    void computeBins( int maxBins );
+
+    std::vector< int > nBinsF_;
+
+    unsigned char **instFeatBin; // per instance
+
+    std::vector< std::vector< double > > binMaxVal_;
+
     std::vector< std::pair<double, double> > limitsFeature;
 };
 
@@ -34,11 +34,11 @@ MIPMultiVariate::MIPMultiVariate( const InstanceSet *_iset, const ResultsSet *_r
 
 void MIPMultiVariate::createYvars()
 {
-    y = vector< int >(iset_->instances().size());
+    y = vector< int >(iset_->nGroups());
     vector<string> cnames;
-    for (const auto &inst : iset_->instances())
+    for ( int ig=0 ; (ig<iset_->nGroups()) ; ++ig )
     {
-        string name = "y("+to_string(inst.idx())+")";
+        string name = "y("+to_string(ig)+")";
         y[cnames.size()] = cnames.size();
         cnames.push_back(name);
     }
@@ -63,7 +63,7 @@ void MIPMultiVariate::createZvars()
         idx[1] = lp_cols(mip) + cnames.size();
         cnames.push_back(string(name));
 
-        w.push_back( idx );
+        z.push_back( idx );
     }
     vector< double > obj(cnames.size(), 0.0);
     char **names = to_char_vec(cnames);
@@ -92,30 +92,32 @@ void MIPMultiVariate::createAvars()
 
 void MIPMultiVariate::createConsLnkAYB()
 {
-    for ( const auto &inst : iset_->instances() )
+    for ( int ig=0 ; (ig<iset_->nGroups()) ; ++ig )
     {
+        // all instances of the group have the same ranks
+        const int idxInst = iset_->groupInstances(ig)[0];
         vector< int > idx;
         vector< double > coef;
         for ( int iFeat=0 ; (iFeat<nFeat) ; ++iFeat )
         {
             idx.push_back(a[iFeat]);
-            coef.push_back(iset_->norm_feature_val_rank(inst.idx(), iFeat));
+            coef.push_back(iset_->norm_feature_val_rank(idxInst, iFeat));
         }
 
         idx.push_back(b);
         coef.push_back(-1.0);
 
-        idx.push_back(y[inst.idx()]);
+        idx.push_back(y[ig]);
         coef.push_back(1.0);
 
         char name[256];
-        sprintf(name, "lnkAYBp1(%d)", (int)inst.idx());
+        sprintf(name, "lnkAYBp1(%d)", ig);
         lp_add_row(mip, idx.size(), &idx[0], &coef[0], name, 'L', 1.0);
 
         const double eps = 1.0 / (double)iset_->size();
 
         *coef.rbegin() = 1.0 + eps;
-        sprintf(name, "lnkAYBp2(%d)", (int)inst.idx());
+        sprintf(name, "lnkAYBp2(%d)", ig);
         lp_add_row(mip, idx.size(), &idx[0], &coef[0], name, 'G', eps);
     }
 }
@@ -143,16 +145,19 @@ void MIPMultiVariate::createWvars()
 {
     vector< string > cnames;
     vector< double > obj;
-    for ( const auto &inst : iset_->instances() ) 
+    for ( int ig=0 ; (ig<iset_->nGroups()) ; ++ig )
     {
         vector< int > idx;
 
         for ( int ia=0 ; (ia<nAlgs) ; ++ia )
         {
             idx.push_back(lp_cols(mip)+cnames.size());
-            obj.push_back(rset_->res(inst.idx(), ia)*1000.0);
+            double res = 0.0;
+            for ( const auto i : iset_->groupInstances(ig) )
+                res += rset_->res(i, ia);
+            obj.push_back(res*1000.0);
             char name[256];
-            sprintf(name, "w(%d,%d)", (int)inst.idx(), ia);
+            sprintf(name, "w(%d,%d)", ig, ia);
             cnames.push_back(name);
         }
         w.push_back(idx);
@@ -164,43 +169,43 @@ void MIPMultiVariate::createWvars()
 
 void MIPMultiVariate::createConsSelAlgProblem()
 {
-    for ( const auto &inst : iset_->instances() )
+    for ( int ig=0 ; (ig<iset_->nGroups()) ; ++ig )
     {
         vector< int > idx;
         for ( int ia=0 ; ia<nAlgs ; ++ia )
-            idx.push_back(w[inst.idx()][ia]);
+            idx.push_back(w[ig][ia]);
 
         vector< double > coef(idx.size(), 1.0);
         char name[256];
-        sprintf(name, "selAlgProb(%d)", (int)inst.idx());
+        sprintf(name, "selAlgProb(%d)", ig);
         lp_add_row(mip, idx.size(), &idx[0], &coef[0], name, 'E', 1.0);
     }
 }
 
 void MIPMultiVariate::createConsLNKWYZ()
 {
-    for ( const auto &inst : iset_->instances() )
+    for ( int ig=0 ; (ig<iset_->nGroups()) ; ++ig )
     {
         for ( int ia=0 ; (ia<nAlgs) ; ++ia )
         {
-            int idx[] = {w[inst.idx()][ia], y[inst.idx()], z[ia][0]};
+            int idx[] = {w[ig][ia], y[ig], z[ia][0]};
             char name[256];
             {
                 double coef[] = { 1.0, -0.5, -0.5};
 
-                sprintf(name, "lnkWYZ(%d,%d)l", (int)inst.idx(), ia);
+                sprintf(name, "lnkWYZ(%d,%d)l", ig, ia);
 
                 lp_add_row(mip, 3, idx, coef, name, 'L', 0.0);
             }
             {
                 double coef[] = { 1.0, 0.5, -0.5};
 
-                sprintf(name, "lnkWYZ(%d,%d)r", (int)inst.idx(), ia);
+                sprintf(name, "lnkWYZ(%d,%d)r", ig, ia);
 
                 lp_add_row(mip, 3, idx, coef, name, 'L', 0.5);
             }
         } // algorithms
-    } // instances
+    } // groups of instances
 }
 
 MIPMultiVariate::~MIPMultiVariate()
@@ -17,17 +17,21 @@
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <iterator>
+#include <limits>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <omp.h>
 
 #include "InstanceSet.hpp"
 #include "Parameters.hpp"
 #include "ResultsSet.hpp"
 #include "Tree.hpp"
 #include "Node.hpp"
+#include "MIPRace.hpp"
 
 #define SEL_LEAF_SCAL 1000.0
 
@@ -55,23 +59,46 @@ static string clean_str( const char *str )
     return res;
 }
 
-MIPPDtree::MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset ) :
+MIPPDtree::MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset, const int _subLevels ) :
     iset_( _iset ),
     rset_( _rset ),
     nLeafs( floor(pow( 2.0, Parameters::maxDepth )-2+1e-5) ),
-    nInsts(_iset->size()),
+    nInsts(_iset->nGroups()),
     nFeatures(_iset->features().size()),
     nAlgs(_rset->algsettings().size()),
+    subLevels( std::max( 0, _subLevels ) ),
+    lazyLnk( Parameters::lazyLnkWCZ && subLevels==0 ),
+#ifdef DEBUG
+    storeNames( true ),
+#else
+    storeNames( Parameters::mipPDTFile.size()>0 || Parameters::checkpointModel ),
+#endif
     mip( lp_create() ),
     c(vector< vector<int> >(nLeafs, vector< int >(nAlgs))),
     w(vector< vector<int> >( nInsts, vector<int>(nAlgs) ) ),
     parents( vector< vector< vector< int > > >( nLeafs, vector< vector<int> >(2)) )
 {
+    if ((int)nInsts<iset_->size())
+    {
+        if (iset_->rankGroups())
+            printf("%d instances aggregated in %zu groups with the same feature ranks\n", iset_->size(), nInsts);
+        else
+            printf("%d instances aggregated in %zu coreset groups, each one represented by its first instance\n", iset_->size(), nInsts);
+    }
+
+    if (subLevels)
+    {
+        printf("leafs estimated by subtrees with %d more levels", subLevels);
+        if (Parameters::lazyLnkWCZ)
+            printf(", their linking constraints are not lazy");
+        printf("\n");
+    }
+
     computeEMax();
 
     // names for instances
     for ( size_t i=0 ; (i<nInsts) ; ++i )
-        insts.push_back( clean_str(iset_->instance(i).name()) );
+        insts.push_back( clean_str(iset_->instance(iset_->groupInstances(i)[0]).name()) );
 
     for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
         algs.push_back( clean_str(rset_->algsettings()[ia].c_str()) );
@@ -111,6 +138,10 @@ MIPPDtree::MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset ) :
         } while (pNodeIdx>0);
     }
 
+    const clock_t startT = clock();
+
+    computeFeatRep();
+
     createBVars();
     createDVars();
     createLVars();
@@ -119,6 +150,9 @@ MIPPDtree::MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset ) :
     createZVars();
     createWVars();
 
+    const clock_t startR = clock();
+
+    rStart.push_back( 0 );
     createConsLnkAD();
     createConsLnkBD();
     createConsOneLeaf();
@@ -127,16 +161,165 @@ MIPPDtree::MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset ) :
     createConsOneLeafPath();
     createConsSelectLeaf();
     createConsOneLeafPerProb();
-    createConsLnkWCZ();
+    if (subLevels)
+        createConsLnkWCZSubtree();
+    else if (!lazyLnk)
+        createConsLnkWCZ();
     createConsSelOneW();
     createConsBranchBeforeLeaf();
     createConsSelAlgLeaf();
+    if (Parameters::mipSymmetry)
+    {
+        createConsChildUsed();
+        // with subLevels sibling leafs may share algorithms
+        if (!subLevels)
+            createConsSiblingAlgs();
+    }
+
+    const clock_t startA = clock();
+    const size_t nz = rIdx.size();
+    flushRows();
+    const clock_t endT = clock();
+
+    printf("\nMIP model with %d variables, %d constraints and %zu non-zeros built in %.2f seconds: "
+        "variables %.2f, constraints %.2f, solver %.2f\n", lp_cols(mip), lp_rows(mip), nz,
+        ((double)endT-startT)/CLOCKS_PER_SEC, ((double)startR-startT)/CLOCKS_PER_SEC,
+        ((double)startA-startR)/CLOCKS_PER_SEC, ((double)endT-startA)/CLOCKS_PER_SEC );
+
+    if (Parameters::mipPriorities)
+        setBranchingPriorities();
+
+    const double *obj = lp_obj_coef( mip );
+    objCoef.assign( obj, obj+lp_cols(mip) );
+    solObj = DBL_MAX;
+
+    if (Parameters::mipPDTFile.size())
+        lp_write_lp(mip, Parameters::mipPDTFile.c_str());
+    if (Parameters::checkpointModel && Parameters::checkpoint.size())
+        lp_write_lp(mip, (Parameters::checkpoint+".lp").c_str());
     
     /*
     createConsLnkParent();
     createConsSelCLeaf();
 */
-    //lp_write_lp(mip, "mm.lp");
+}
+
+void MIPPDtree::computeFeatRep()
+{
+    featRep = vector< int >( nFeatures );
+    for ( size_t idxF=0 ; (idxF<nFeatures) ; ++idxF )
+    {
+        featRep[idxF] = idxF;
+        if (!Parameters::mipSymmetry)
+            continue;
+
+        // features with the same ranks for all instances
+        // are interchangeable: only the first one is used
+        for ( size_t idxF2=0 ; (idxF2<idxF) ; ++idxF2 )
+        {
+            if (featRep[idxF2]!=(int)idxF2)
+                continue;
+
+            bool equal = true;
+            for ( size_t i=0 ; (i<nInsts && equal) ; ++i )
+            {
+                const int idxInst = iset_->groupInstances(i)[0];
+                equal = fabs(iset_->norm_feature_val_rank(idxInst, idxF)-iset_->norm_feature_val_rank(idxInst, idxF2))<1e-10;
+            }
+
+            if (equal)
+            {
+                featRep[idxF] = idxF2;
+                break;
+            }
+        }
+    }
+}
+
+void MIPPDtree::createConsChildUsed()
+{
+    // a branched node which is not the root has its two children
+    // used, as leafs or branches: otherwise its instances all go to
+    // one side and removing the branch gives a cheaper tree
+    for ( size_t idxN=1 ; (idxN<branchNodes.size()) ; ++idxN )
+    {
+        for ( size_t ch=idxN*2+1 ; (ch<=idxN*2+2) ; ++ch )
+        {
+            int idx[] = { l[ch-1], d[idxN], -1 };
+            double coef[] = { 1.0, -1.0, 1.0 };
+            int nz = 2;
+            if (ch<branchNodes.size())
+                idx[nz++] = d[ch];
+
+            char rName[256] = "";
+            if (storeNames)
+                sprintf( rName, "childUsed(%s,%s)", branchNodes[idxN].c_str(), leafNodes[ch-1].c_str() );
+            addRow( nz, idx, coef, rName, 'G', 0.0 );
+        }
+    }
+}
+
+void MIPPDtree::createConsSiblingAlgs()
+{
+    // two sibling leafs with the same algorithm can be merged
+    // in their parent, if it is not the root
+    for ( size_t idxN=1 ; (idxN<branchNodes.size()) ; ++idxN )
+    {
+        const size_t left = idxN*2, right = idxN*2+1;
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+        {
+            int idx[] = { c[left][ia], c[right][ia] };
+            double coef[] = { 1.0, 1.0 };
+
+            char rName[256] = "";
+            if (storeNames)
+                sprintf( rName, "siblingAlgs(%s,%zu)", branchNodes[idxN].c_str(), ia );
+            addRow( 2, idx, coef, rName, 'L', 1.0 );
+        }
+    }
+}
+
+void MIPPDtree::setBranchingPriorities()
+{
+    // higher priorities are branched first
+    vector< int > priorities( lp_cols(mip), 0 );
+    for ( const auto id : d )
+        priorities[id] = 3;
+    for ( const auto &af : a )
+        for ( const auto ia : af )
+            if (ia>=0)
+                priorities[ia] = 2;
+    for ( const auto &zi : z )
+        for ( const auto iz : zi )
+            priorities[iz] = 1;
+
+    lp_set_branching_priorities( mip, &priorities[0] );
+}
+
+void MIPPDtree::addRow( int nz, const int *idx, const double *coef, const char *name, char sense, double rhs )
+{
+    rIdx.insert( rIdx.end(), idx, idx+nz );
+    rCoef.insert( rCoef.end(), coef, coef+nz );
+    rStart.push_back( (int)rIdx.size() );
+    rSense.push_back( sense );
+    rRHS.push_back( rhs );
+    if (storeNames)
+        rNames.push_back( string(name) );
+}
+
+void MIPPDtree::flushRows()
+{
+    char **names = storeNames ? to_char_vec(rNames) : nullptr;
+
+    lp_add_rows( mip, (int)rSense.size(), &rStart[0], &rIdx[0], &rCoef[0], &rSense[0], &rRHS[0], (const char **)names );
+
+    if (names)
+        free( names );
+
+    rStart.clear(); rIdx.clear(); rCoef.clear(); rSense.clear(); rRHS.clear(); rNames.clear();
+    rStart.shrink_to_fit(); rIdx.shrink_to_fit(); rCoef.shrink_to_fit();
+    rSense.shrink_to_fit(); rRHS.shrink_to_fit(); rNames.shrink_to_fit();
+    rStart.push_back( 0 );
 }
 
 void MIPPDtree::createBVars()
@@ -190,7 +373,7 @@ void MIPPDtree::createAVars()
     {
         for ( size_t idxN=0 ; (idxN<branchNodes.size()) ; ++idxN )
         {
-            if (iset_->nValidBranchingsFeature(idxF))
+            if (iset_->nValidBranchingsFeature(idxF) && featRep[idxF]==(int)idxF)
             {
                 char vname[512];
                 sprintf(vname, "a(%s,%s)",
@@ -224,16 +407,17 @@ void MIPPDtree::createConsLnkAD()
 
         int nz = 0;
         for ( size_t idxF=0 ; (idxF<iset_->features().size()) ; ++idxF )
-            if (iset_->nValidBranchingsFeature(idxF))
+            if (a[idxF][idxN]>=0)
                 idx[nz++] = a[idxF][idxN];
 
         coef[nz] = -1.0;
         idx[nz] = d[idxN];
         ++nz;
 
-        char rname[256];
-        sprintf( rname, "lnkAD(%s)", branchNodes[idxN].c_str() );
-        lp_add_row(mip, nz, &idx[0], &coef[0], rname, 'E', 0.0 );
+        char rname[256] = "";
+        if (storeNames)
+            sprintf( rname, "lnkAD(%s)", branchNodes[idxN].c_str() );
+        addRow( nz, &idx[0], &coef[0], rname, 'E', 0.0 );
     }
 }
 
@@ -282,8 +466,9 @@ void MIPPDtree::createConsLnkBD()
         double coef[] = { 1.0, -1.0 };
         int idx[] = { b[i], d[i] };
         char rname[256] = "";
-        sprintf(rname, "lnkbd(%s)", branchNodes[i].c_str() );
-        lp_add_row(mip, 2, idx, coef, rname, 'L', 0.0);
+        if (storeNames)
+            sprintf(rname, "lnkbd(%s)", branchNodes[i].c_str() );
+        addRow( 2, idx, coef, rname, 'L', 0.0);
     }
 }
 
@@ -320,24 +505,29 @@ void MIPPDtree::createConsLNKZL()
         {
             int idx[] = { z[i][j], l[j] };
             double coef[] = { 1.0, -1.0 };
-            char rName[256];
-            sprintf( rName, "lnkZLUp(%zu,%zu)", i, j );
-            lp_add_row(mip, 2, idx, coef, rName, 'L', 0.0);
+            char rName[256] = "";
+            if (storeNames)
+                sprintf( rName, "lnkZLUp(%zu,%zu)", i, j );
+            addRow( 2, idx, coef, rName, 'L', 0.0);
         }
     }
 
     for ( size_t j=0 ; (j<nLeafs) ; ++j )
     {
-        char rName[256];
-        sprintf( rName, "minElementsLeaf(%s)", leafNodes[j].c_str() );
+        char rName[256] = "";
+        if (storeNames)
+            sprintf( rName, "minElementsLeaf(%s)", leafNodes[j].c_str() );
         vector< int > idx( nInsts+1 );
         vector< double > coef( nInsts+1, 1.0 );
         *idx.rbegin() = l[j];
         *coef.rbegin() = -((int)Parameters::minElementsBranch);
         for ( size_t i=0 ; (i<nInsts) ; ++i )
+        {
             idx[i] = z[i][j];
+            coef[i] = iset_->groupInstances(i).size();
+        }
 
-        lp_add_row( mip, nInsts+1, &idx[0], &coef[0], rName, 'G', 0.0 );
+        addRow( nInsts+1, &idx[0], &coef[0], rName, 'G', 0.0 );
     }
 }
 
@@ -356,7 +546,7 @@ void MIPPDtree::createConsSelectLeaf()
 
                 for ( size_t idxF=0 ; (idxF<nFeatures) ; ++idxF )
                 {
-                    double nfv = iset_->norm_feature_val_rank(i, idxF);
+                    double nfv = iset_->norm_feature_val_rank(iset_->groupInstances(i)[0], idxF);
 
                     double c = nfv*SEL_LEAF_SCAL;
 
@@ -376,14 +566,16 @@ void MIPPDtree::createConsSelectLeaf()
                 idx.push_back( z[i][idxL] );
                 coef.push_back( 1.0*SEL_LEAF_SCAL );
 
-                char rName[256];
+                char rName[256] = "";
 #ifdef DEBUG
-                sprintf(rName, "selNAL(%s,%s,%s)", insts[i].c_str(), leafNodes[idxL].c_str(), branchNodes[leftN].c_str() );
+                if (storeNames)
+                    sprintf(rName, "selNAL(%s,%s,%s)", insts[i].c_str(), leafNodes[idxL].c_str(), branchNodes[leftN].c_str() );
 #else
-                sprintf(rName, "selNAL(%zu,%s,%s)", i, leafNodes[idxL].c_str(), branchNodes[leftN].c_str() );
+                if (storeNames)
+                    sprintf(rName, "selNAL(%zu,%s,%s)", i, leafNodes[idxL].c_str(), branchNodes[leftN].c_str() );
 #endif
 
-                lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'L', 1.0*SEL_LEAF_SCAL );
+                addRow( idx.size(), &idx[0], &coef[0], rName, 'L', 1.0*SEL_LEAF_SCAL );
             } // parents at left
 
             for ( const auto rightN : parents[idxL][Right] )
@@ -397,7 +589,7 @@ void MIPPDtree::createConsSelectLeaf()
                 {
                     assert(epsj[idxF] >= 0.0-1e-10 && epsj[idxF]<=1.0+1e-10 );
 
-                    double nfv = (double)iset_->norm_feature_val_rank( i, idxF )-epsj[idxF];
+                    double nfv = (double)iset_->norm_feature_val_rank( iset_->groupInstances(i)[0], idxF )-epsj[idxF];
 
                     double c = nfv*SEL_LEAF_SCAL;
 
@@ -417,14 +609,16 @@ void MIPPDtree::createConsSelectLeaf()
                 idx.push_back( z[i][idxL] );
                 coef.push_back( -2.0*SEL_LEAF_SCAL  );
 
-                char rName[256];
+                char rName[256] = "";
 #ifdef DEBUG
-                sprintf(rName, "selNRL(%s,%s,%s)", insts[i].c_str(), leafNodes[idxL].c_str(), branchNodes[rightN].c_str() );
+                if (storeNames)
+                    sprintf(rName, "selNRL(%s,%s,%s)", insts[i].c_str(), leafNodes[idxL].c_str(), branchNodes[rightN].c_str() );
 #else
-                sprintf(rName, "selNRL(%zu,%s,%s)", i, leafNodes[idxL].c_str(), branchNodes[rightN].c_str() );
+                if (storeNames)
+                    sprintf(rName, "selNRL(%zu,%s,%s)", i, leafNodes[idxL].c_str(), branchNodes[rightN].c_str() );
 #endif
 
-                lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'G', -2.0*SEL_LEAF_SCAL );
+                addRow( idx.size(), &idx[0], &coef[0], rName, 'G', -2.0*SEL_LEAF_SCAL );
             } // parents at right
         } // leafs
     } // instances
@@ -438,7 +632,7 @@ void MIPPDtree::computeEMax()
     {
         unordered_set<double> values;
         for ( size_t i=0 ; (i<nInsts) ; ++i )
-            values.insert( iset_->norm_feature_val_rank(i, idxF) );
+            values.insert( iset_->norm_feature_val_rank(iset_->groupInstances(i)[0], idxF) );
 
         vector< double > sv(values.begin(), values.end());
         sort( sv.begin(), sv.end());
@@ -466,8 +660,9 @@ void MIPPDtree::createConsOneLeaf()
 {
     for ( size_t i=0 ; (i<nInsts) ; ++i  )
     {
-        char rName[256];
-        sprintf(rName, "selLeaf(%zu)", i);
+        char rName[256] = "";
+        if (storeNames)
+            sprintf(rName, "selLeaf(%zu)", i);
 
         vector< int >idx( nLeafs );
         for ( size_t idxLeaf=0 ; (idxLeaf<nLeafs) ; ++idxLeaf )
@@ -475,7 +670,7 @@ void MIPPDtree::createConsOneLeaf()
 
         vector< double >coef( nLeafs, 1.0 );
 
-        lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'E', 1.0);
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'E', 1.0);
     }
 }
 
@@ -521,7 +716,10 @@ void MIPPDtree::createWVars()
 #endif
             w[idxInst][idxAlg] = lp_cols(mip) + cnames.size();
             cnames.push_back(cName);
-            obj.push_back( (rset_->res(idxInst, idxAlg)*foMult) );
+            double res = 0.0;
+            for ( const auto i : iset_->groupInstances(idxInst) )
+                res += rset_->res(i, idxAlg);
+            obj.push_back( (res*foMult) );
         }
     }
 
@@ -533,35 +731,83 @@ void MIPPDtree::createWVars()
 
 void MIPPDtree::createConsLnkWCZ()
 {
+    vector< int > idx( 2*nAlgs+1 );
+    vector< double > coef( 2*nAlgs+1 );
+    for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
+    {
+        coef[idxAlg*2] = (((int)idxAlg)+1);
+        coef[idxAlg*2+1] = -(((int)idxAlg+1));
+    }
+
     for ( size_t i=0 ; (i<nInsts) ; ++i )
     {
         for ( size_t idxL=0 ; (idxL<nLeafs) ; ++idxL )
         {
-            vector< int > idx;
-            vector< double > coef;
-
             for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
             {
-                idx.push_back(w[i][idxAlg]);
-                coef.push_back((((int)idxAlg)+1));
-                idx.push_back(c[idxL][idxAlg]);
-                coef.push_back(-(((int)idxAlg+1)));
+                idx[idxAlg*2] = w[i][idxAlg];
+                idx[idxAlg*2+1] = c[idxL][idxAlg];
             }
 
-            idx.push_back( z[i][idxL] );
-            coef.push_back( -((int)nAlgs) );
+            idx[nAlgs*2] = z[i][idxL];
+            coef[nAlgs*2] = -((int)nAlgs);
 
-            char rName[256]; sprintf( rName, "lnkWCZL(%zu,%zu)", i, idxL );
-            lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'G', -((int)nAlgs) );
+            char rName[256] = "";
+            if (storeNames)
+                sprintf( rName, "lnkWCZL(%zu,%zu)", i, idxL );
+            addRow( idx.size(), &idx[0], &coef[0], rName, 'G', -((int)nAlgs) );
 
-            *coef.rbegin() = nAlgs;
-            sprintf( rName, "lnkWCZU(%zu,%zu)", i, idxL );
-            lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'L', nAlgs );
+            coef[nAlgs*2] = nAlgs;
+            if (storeNames)
+                sprintf( rName, "lnkWCZU(%zu,%zu)", i, idxL );
+            addRow( idx.size(), &idx[0], &coef[0], rName, 'L', nAlgs );
         }
 
     }
 }
 
+int MIPPDtree::maxLeafAlgs( size_t iln ) const
+{
+    if (subLevels==0)
+        return 1;
+
+    // leaf iln is node iln+1, at depth floor(log2(iln+2))
+    int depth = 0;
+    for ( size_t n=iln+2 ; (n>1) ; n/=2 )
+        ++depth;
+
+    const int levels = subLevels + ((int)Parameters::maxDepth)-1-depth;
+    if (levels>=30)
+        return (int)nAlgs;
+
+    return std::min( (int)nAlgs, 1<<levels );
+}
+
+void MIPPDtree::createConsLnkWCZSubtree()
+{
+    // optimistic estimate of the subtree below each leaf: it selects
+    // up to one algorithm per leaf of the subtree and each instance
+    // uses the best selected one, as if any partition of the instances
+    // was possible. an instance in leaf idxL only uses an algorithm
+    // selected there: w(i,a) + z(i,idxL) - c(idxL,a) <= 1
+    for ( size_t i=0 ; (i<nInsts) ; ++i )
+    {
+        for ( size_t idxL=0 ; (idxL<nLeafs) ; ++idxL )
+        {
+            for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
+            {
+                int idx[] = { w[i][idxAlg], z[i][idxL], c[idxL][idxAlg] };
+                double coef[] = { 1.0, 1.0, -1.0 };
+
+                char rName[256] = "";
+                if (storeNames)
+                    sprintf( rName, "lnkWCZS(%zu,%zu,%zu)", i, idxL, idxAlg );
+                addRow( 3, idx, coef, rName, 'L', 1.0 );
+            }
+        }
+    }
+}
+
 /*
 void MIPPDtree::createConsLnkParent()
 {
@@ -581,11 +827,13 @@ void MIPPDtree::createConsLnkParent()
 
 Tree *MIPPDtree::build( const int maxSeconds )
 {
-    if (maxSeconds!=INT_MAX)
-        lp_set_max_seconds( mip, maxSeconds );
-    
     lp_set_mip_emphasis(mip, LP_ME_FEASIBILITY);
-    int st = lp_optimize( mip );
+
+    savedCost = DBL_MAX;
+    if (Parameters::lns>0)
+        return buildLNS( maxSeconds );
+
+    const int st = solveModel( maxSeconds );
     assert( st != LP_UNBOUNDED && st != LP_INFEASIBLE && st != LP_INTINFEASIBLE );
     
     if ( st != LP_OPTIMAL && st != LP_FEASIBLE )
@@ -594,9 +842,10 @@ Tree *MIPPDtree::build( const int maxSeconds )
         return nullptr;
     }
     
-    lp_write_sol(mip, "a.sol");
+    if (Parameters::checkpoint.size())
+        lp_write_x_atomic( mip, Parameters::checkpoint.c_str(), &solX[0], solObj );
 
-    const double *x = lp_x(mip);
+    const double *x = &solX[0];
     
     if (x[d[0]]<=0.01)
     {
@@ -604,6 +853,493 @@ Tree *MIPPDtree::build( const int maxSeconds )
         return nullptr;
     }
 
+    return treeFromSolution( x );
+}
+
+Tree *MIPPDtree::buildLNS( const int maxSeconds )
+{
+    // neighbourhoods: branch nodes which are free, the other ones keep
+    // their branching features. all subtrees below the root and all levels
+    vector< vector< int > > neighs;
+    for ( size_t n=1 ; (n<branchNodes.size()) ; ++n )
+    {
+        vector< int > nodes;
+        nodes.push_back( n );
+        for ( size_t i=0 ; (i<nodes.size()) ; ++i )
+            for ( size_t ch=nodes[i]*2+1 ; (ch<=(size_t)nodes[i]*2+2 && ch<branchNodes.size()) ; ++ch )
+                nodes.push_back( ch );
+        neighs.push_back( nodes );
+    }
+    for ( size_t first=0 ; (first<branchNodes.size()) ; first=first*2+1 )
+    {
+        vector< int > nodes;
+        for ( size_t n=first ; (n<=first*2 && n<branchNodes.size()) ; ++n )
+            nodes.push_back( n );
+        neighs.push_back( nodes );
+    }
+
+    // without an initial solution the first neighbourhood is the whole tree
+    if (incFeat.empty())
+    {
+        incFeat = vector< int >( branchNodes.size(), -1 );
+        vector< int > nodes;
+        for ( size_t n=0 ; (n<branchNodes.size()) ; ++n )
+            nodes.push_back( n );
+        neighs.insert( neighs.begin(), nodes );
+    }
+
+    // fixes the branch nodes of lp outside the neighbourhood nodes to
+    // the incumbent, keeping in fixed, lb and ub the columns fixed and
+    // their previous bounds
+    auto fixOutside = [&] ( LinearProgram *lp, const vector< int > &nodes,
+            vector< int > &fixed, vector< double > &lb, vector< double > &ub ) {
+        vector< char > isFree( branchNodes.size(), 0 );
+        for ( auto n : nodes )
+            isFree[n] = 1;
+        fixed.clear();
+        vector< double > val;
+        for ( size_t n=0 ; (n<branchNodes.size()) ; ++n )
+        {
+            if (isFree[n])
+                continue;
+            fixed.push_back( d[n] );
+            val.push_back( (incFeat[n]>=0) ? 1.0 : 0.0 );
+            for ( size_t idxF=0 ; (idxF<nFeatures) ; ++idxF )
+            {
+                if (a[idxF][n]<0)
+                    continue;
+                fixed.push_back( a[idxF][n] );
+                val.push_back( (incFeat[n]==(int)idxF) ? 1.0 : 0.0 );
+            }
+        }
+        lb.resize( fixed.size() );
+        ub.resize( fixed.size() );
+        for ( size_t j=0 ; (j<fixed.size()) ; ++j )
+        {
+            lb[j] = lp_col_lb( lp, fixed[j] );
+            ub[j] = lp_col_ub( lp, fixed[j] );
+            lp_set_col_bounds( lp, fixed[j], val[j], val[j] );
+        }
+    };
+
+    // batches of nPar neighbourhoods are solved concurrently, each one
+    // in a copy of mip with its own solver environment and a share of
+    // the cores. a single neighbourhood is solved in mip by solveModel
+    const int nProcs = omp_get_num_procs();
+    const size_t nPar = std::min( neighs.size(),
+        (size_t)((Parameters::lnsParallel>0) ? Parameters::lnsParallel : nProcs) );
+
+    const time_t startT = time(nullptr);
+    double bestObj = DBL_MAX;
+    vector< double > incX;
+    vector< int > idx( lp_cols(mip) );
+    for ( size_t j=0 ; (j<idx.size()) ; ++j )
+        idx[j] = j;
+    size_t nFail = 0;
+    for ( size_t in=0 ; (nFail<neighs.size()) ; in=(in+nPar)%neighs.size() )
+    {
+        const double elapsed = difftime( time(nullptr), startT );
+        if (maxSeconds!=INT_MAX && elapsed>=maxSeconds)
+            break;
+
+        int secs = Parameters::lns;
+        if (maxSeconds!=INT_MAX)
+            secs = std::max( 1, std::min( secs, (int)(maxSeconds-elapsed) ) );
+
+        vector< size_t > batch;
+        for ( size_t k=0 ; (k<nPar) ; ++k )
+            batch.push_back( (in+k)%neighs.size() );
+        vector< LinearProgram * > lps( nPar, mip );
+        vector< int > st( nPar, LP_NO_SOL_FOUND );
+        vector< int > fixed;
+        vector< double > lb, ub;
+        if (nPar==1)
+        {
+            fixOutside( mip, neighs[in], fixed, lb, ub );
+            if (incX.size())
+                lp_load_mip_starti( mip, (int)incX.size(), &idx[0], &incX[0] );
+            st[0] = solveModel( secs );
+            // with race, mip is replaced by the copy which won
+            lps[0] = mip;
+            for ( size_t j=0 ; (j<fixed.size()) ; ++j )
+                lp_set_col_bounds( mip, fixed[j], lb[j], ub[j] );
+        }
+        else
+        {
+            // copies include the lnkWCZ constraints added so far
+            for ( size_t k=0 ; (k<nPar) ; ++k )
+            {
+                lps[k] = lp_clone_own_env( mip );
+                lp_set_threads( lps[k], std::max( 1, nProcs/((int)nPar) ) );
+                lp_set_max_seconds( lps[k], secs );
+                fixOutside( lps[k], neighs[batch[k]], fixed, lb, ub );
+                if (incX.size())
+                    lp_load_mip_starti( lps[k], (int)incX.size(), &idx[0], &incX[0] );
+            }
+#pragma omp parallel for num_threads(nPar) schedule(static, 1)
+            for ( size_t k=0 ; k<nPar ; ++k )
+                st[k] = lp_optimize( lps[k] );
+        }
+
+        // the cheapest valid solution of the batch is the new incumbent:
+        // solveModel returns one for mip, solutions of copies violating
+        // lazy lnkWCZ constraints are repaired
+        int bestK = -1;
+        vector< vector< double > > candX( nPar );
+        vector< double > candObj( nPar, DBL_MAX );
+        for ( size_t k=0 ; (k<nPar) ; ++k )
+        {
+            if ( st[k] != LP_OPTIMAL && st[k] != LP_FEASIBLE )
+                continue;
+            if (lps[k]==mip)
+            {
+                candX[k] = solX;
+                candObj[k] = solObj;
+            }
+            else
+            {
+                const double *x = lp_x(lps[k]);
+                candX[k].assign( x, x+lp_cols(lps[k]) );
+                candObj[k] = lp_obj_value(lps[k]);
+                if (lazyLnk && separateLnkWCZ( x ))
+                    candObj[k] = repairLnkWCZ( candX[k] );
+            }
+            if (candObj[k]<bestObj-1e-6 && (bestK==-1 || candObj[k]<candObj[bestK]))
+                bestK = k;
+        }
+
+        if (bestK>=0)
+        {
+            LinearProgram *lp = lps[bestK];
+            bestObj = candObj[bestK];
+            incX = candX[bestK];
+            const double *x = &incX[0];
+            for ( size_t n=0 ; (n<branchNodes.size()) ; ++n )
+            {
+                incFeat[n] = -1;
+                if (x[d[n]]<0.01)
+                    continue;
+                for ( size_t idxF=0 ; (idxF<nFeatures) ; ++idxF )
+                    if (a[idxF][n]>=0 && x[a[idxF][n]]>0.99)
+                        incFeat[n] = idxF;
+            }
+            nFail = 0;
+            if (lp!=mip && (Parameters::anytime>0 || Parameters::checkpoint.size()))
+                saveIncumbent( lp, difftime( time(nullptr), startT ) );
+            cout << "LNS: neighbourhood " << batch[bestK] << " (" << neighs[batch[bestK]].size() <<
+                " free branch nodes) improved objective to " << bestObj << ", " <<
+                difftime( time(nullptr), startT ) << " seconds" << endl;
+        }
+        else
+            nFail += nPar;
+
+        for ( size_t k=0 ; (k<nPar) ; ++k )
+            if (lps[k]!=mip)
+                lp_free( &lps[k] );
+    }
+
+    if (incX.empty() || incX[d[0]]<=0.01)
+    {
+        printf("No solution with branches found by LNS.\n");
+        return nullptr;
+    }
+
+    return treeFromSolution( &incX[0] );
+}
+
+bool MIPPDtree::resume()
+{
+    FILE *f = fopen( Parameters::checkpoint.c_str(), "r" );
+    if (f == nullptr)
+    {
+        cout << "no checkpoint in " << Parameters::checkpoint << ", starting from the initial solution" << endl;
+        return false;
+    }
+    fclose( f );
+
+    lp_read_mip_start( mip, Parameters::checkpoint.c_str() );
+
+    // the features of the initial solution are not the ones of the checkpoint
+    incFeat.clear();
+
+    return true;
+}
+
+int MIPPDtree::solveModel( const int maxSeconds )
+{
+    const time_t startT = time(nullptr);
+    solX.clear();
+    solObj = DBL_MAX;
+    int st;
+    while (true)
+    {
+        int remaining = maxSeconds;
+        if (maxSeconds!=INT_MAX)
+            remaining = std::max( 1, (int)(maxSeconds-difftime( time(nullptr), startT )) );
+
+        if (Parameters::race>1)
+            st = mip_race( &mip, Parameters::race, remaining, Parameters::raceSeconds, raceImproved, this );
+        else if (Parameters::anytime>0 || Parameters::checkpoint.size())
+            st = optimizeAnytime( remaining );
+        else
+        {
+            if (remaining!=INT_MAX)
+                lp_set_max_seconds( mip, remaining );
+            st = lp_optimize( mip );
+        }
+
+        if ( st != LP_OPTIMAL && st != LP_FEASIBLE )
+        {
+            // a repaired solution of a previous round remains valid
+            if (solX.size())
+                st = LP_FEASIBLE;
+            break;
+        }
+
+        const double *x = lp_x(mip);
+        if (!lazyLnk)
+        {
+            solX.assign( x, x+lp_cols(mip) );
+            solObj = lp_obj_value(mip);
+            break;
+        }
+
+        // solutions are only valid if no lnkWCZ constraint is violated
+        const int nViol = separateLnkWCZ( x );
+        cout << nViol << " violated lnkWCZ constraints added" << endl;
+        if (nViol==0)
+        {
+            solX.assign( x, x+lp_cols(mip) );
+            solObj = lp_obj_value(mip);
+            break;
+        }
+
+        // the solution repaired is valid and, if the best one so far,
+        // the start of the next round
+        vector< double > repX( x, x+lp_cols(mip) );
+        const double repObj = repairLnkWCZ( repX );
+        if (repObj<solObj)
+        {
+            solX = repX;
+            solObj = repObj;
+        }
+
+        if (maxSeconds!=INT_MAX && difftime( time(nullptr), startT )>=maxSeconds)
+        {
+            printf("Time limit reached, lnkWCZ constraints still violated in the MIP solution, "
+                "repaired solution with objective %g kept.\n", solObj);
+            st = LP_FEASIBLE;
+            break;
+        }
+
+        vector< int > idx( solX.size() );
+        for ( size_t j=0 ; (j<idx.size()) ; ++j )
+            idx[j] = j;
+        lp_load_mip_starti( mip, (int)solX.size(), &idx[0], &solX[0] );
+    }
+
+    return st;
+}
+
+double MIPPDtree::repairLnkWCZ( vector< double > &x ) const
+{
+    assert( subLevels==0 );
+
+    // branchings are kept: each used leaf selects the best algorithm
+    // for its instances, with symmetry breaking one different from
+    // the one of its sibling leaf
+    vector< int > leafAlg( nLeafs, -1 );
+    for ( size_t idxL=0 ; (idxL<nLeafs) ; ++idxL )
+    {
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            x[c[idxL][ia]] = 0.0;
+        if (x[l[idxL]]<0.5)
+            continue;
+
+        vector< double > cost( nAlgs, 0.0 );
+        for ( size_t i=0 ; (i<nInsts) ; ++i )
+            if (x[z[i][idxL]]>0.5)
+                for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+                    cost[ia] += objCoef[w[i][ia]];
+
+        const int sibAlg = (Parameters::mipSymmetry && idxL>=2 && idxL%2) ? leafAlg[idxL-1] : -1;
+        int best = -1;
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            if ((int)ia!=sibAlg && (best==-1 || cost[ia]<cost[best]))
+                best = ia;
+        if (best==-1)
+            best = 0;
+
+        leafAlg[idxL] = best;
+        x[c[idxL][best]] = 1.0;
+    }
+
+    for ( size_t i=0 ; (i<nInsts) ; ++i )
+    {
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            x[w[i][ia]] = 0.0;
+        for ( size_t idxL=0 ; (idxL<nLeafs) ; ++idxL )
+        {
+            if (x[z[i][idxL]]>0.5 && leafAlg[idxL]>=0)
+            {
+                x[w[i][leafAlg[idxL]]] = 1.0;
+                break;
+            }
+        }
+    }
+
+    double obj = 0.0;
+    for ( size_t j=0 ; (j<x.size()) ; ++j )
+        obj += objCoef[j]*x[j];
+
+    return obj;
+}
+
+int MIPPDtree::separateLnkWCZ( const double *x )
+{
+    if (lazyAdded.empty())
+        lazyAdded = vector< char >( nInsts*nLeafs*2, 0 );
+
+    vector< int > idx( 2*nAlgs+1 );
+    vector< double > coef( 2*nAlgs+1 );
+    for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
+    {
+        coef[idxAlg*2] = (((int)idxAlg)+1);
+        coef[idxAlg*2+1] = -(((int)idxAlg+1));
+    }
+
+    int nViol = 0;
+    for ( size_t i=0 ; (i<nInsts) ; ++i )
+    {
+        for ( size_t idxL=0 ; (idxL<nLeafs) ; ++idxL )
+        {
+            char *added = &lazyAdded[(i*nLeafs+idxL)*2];
+            if (added[0] && added[1])
+                continue;
+
+            // sum of indexes of the algorithm selected for i
+            // minus the one selected for the leaf
+            double lhs = 0.0;
+            for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
+                lhs += (((int)idxAlg)+1)*(x[w[i][idxAlg]]-x[c[idxL][idxAlg]]);
+
+            const double slack = nAlgs*(1.0-x[z[i][idxL]]);
+            const bool violL = (!added[0] && lhs < -slack-1e-6);
+            const bool violU = (!added[1] && lhs > slack+1e-6);
+            if (!violL && !violU)
+                continue;
+
+            for ( size_t idxAlg=0 ; (idxAlg<nAlgs) ; ++idxAlg )
+            {
+                idx[idxAlg*2] = w[i][idxAlg];
+                idx[idxAlg*2+1] = c[idxL][idxAlg];
+            }
+            idx[nAlgs*2] = z[i][idxL];
+
+            char rName[256] = "";
+            if (violL)
+            {
+                coef[nAlgs*2] = -((int)nAlgs);
+                if (storeNames)
+                    sprintf( rName, "lnkWCZL(%zu,%zu)", i, idxL );
+                lp_add_cut( mip, idx.size(), &idx[0], &coef[0], rName, 'G', -((int)nAlgs) );
+                added[0] = 1;
+                ++nViol;
+            }
+            if (violU)
+            {
+                coef[nAlgs*2] = nAlgs;
+                if (storeNames)
+                    sprintf( rName, "lnkWCZU(%zu,%zu)", i, idxL );
+                lp_add_cut( mip, idx.size(), &idx[0], &coef[0], rName, 'L', nAlgs );
+                added[1] = 1;
+                ++nViol;
+            }
+        }
+    }
+
+    return nViol;
+}
+
+int MIPPDtree::optimizeAnytime( const int maxSeconds )
+{
+    // optimizes in slices of Parameters::anytime (or checkpointSeconds)
+    // seconds: the search is resumed in each call while the problem
+    // is not modified
+    const time_t startT = time(nullptr);
+    double bestObj = DBL_MAX;
+    int st = LP_NO_SOL_FOUND;
+    while (true)
+    {
+        const double elapsed = difftime( time(nullptr), startT );
+        if (elapsed>=maxSeconds)
+            break;
+
+        const int every = (Parameters::anytime>0) ? Parameters::anytime : Parameters::checkpointSeconds;
+        const int slice = (int)std::min( (double)every, maxSeconds-elapsed );
+        lp_set_max_seconds( mip, std::max( slice, 1 ) );
+        st = lp_optimize( mip );
+        if ( st != LP_OPTIMAL && st != LP_FEASIBLE && st != LP_NO_SOL_FOUND )
+            break;
+
+        if ( (st == LP_OPTIMAL || st == LP_FEASIBLE) && lp_obj_value(mip)<bestObj-1e-9 )
+        {
+            bestObj = lp_obj_value(mip);
+            saveIncumbent( mip, difftime( time(nullptr), startT ) );
+        }
+        else
+            cout << "bound " << lp_best_bound(mip) << ", " << difftime( time(nullptr), startT ) << " seconds" << endl;
+
+        if (st == LP_OPTIMAL)
+            break;
+    }
+
+    return st;
+}
+
+void MIPPDtree::saveIncumbent( LinearProgram *lp, const double secs )
+{
+    const double *x = lp_x(lp);
+    if (Parameters::checkpoint.size())
+    {
+        if (lazyLnk)
+        {
+            // lnkWCZ constraints not added yet may be violated
+            vector< double > repX( x, x+lp_cols(lp) );
+            const double repObj = repairLnkWCZ( repX );
+            lp_write_x_atomic( lp, Parameters::checkpoint.c_str(), &repX[0], repObj );
+            cout << "checkpoint with objective " << repObj << " saved, " << secs << " seconds" << endl;
+        }
+        else
+        {
+            lp_write_sol_atomic( lp, Parameters::checkpoint.c_str() );
+            cout << "checkpoint with objective " << lp_obj_value(lp) << " saved, " << secs << " seconds" << endl;
+        }
+    }
+    if (Parameters::anytime>0 && x[d[0]]>0.01)
+    {
+        Tree *tree = treeFromSolution( x );
+        // with lazy constraints, solutions of previous rounds may be better
+        if (tree->cost()<savedCost)
+        {
+            savedCost = tree->cost();
+            tree->saveFiles();
+            cout << endl << "improved tree with objective " << lp_obj_value(lp) << " saved, tree cost " <<
+                tree->cost() << ", bound " << lp_best_bound(lp) << ", " << secs << " seconds" << endl;
+        }
+        delete tree;
+    }
+}
+
+void MIPPDtree::raceImproved( LinearProgram *lp, double seconds, void *data )
+{
+    MIPPDtree *mpdt = (MIPPDtree *)data;
+    if (Parameters::anytime>0 || Parameters::checkpoint.size())
+        mpdt->saveIncumbent( lp, seconds );
+}
+
+Tree *MIPPDtree::treeFromSolution( const double *x )
+{
     vector< pair<int, Node*> > queue;
 
     Tree *tree = new Tree(iset_, rset_);
@@ -682,9 +1418,10 @@ void MIPPDtree::createConsBranchOrLeaf()
         vector< double > coef(idx.size(), 1.0);
 
         char rName[256] = "";
-        sprintf(rName, "branchOrLeaf(%s)", leafNodes[idxL].c_str() );
+        if (storeNames)
+            sprintf(rName, "branchOrLeaf(%s)", leafNodes[idxL].c_str() );
 
-        lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'L', 1.0 );
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'L', 1.0 );
     }
 }
 
@@ -714,9 +1451,10 @@ void MIPPDtree::createConsOneLeafPath()
         vector< double > coef( idx.size(), 1.0 );
 
         char rName[256] = "";
-        sprintf( rName, "oneLeafPath(%s)", leafNodes[idxL].c_str() );
+        if (storeNames)
+            sprintf( rName, "oneLeafPath(%s)", leafNodes[idxL].c_str() );
 
-        lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'L', 1.0 );
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'L', 1.0 );
     }
 }
 
@@ -729,10 +1467,11 @@ void MIPPDtree::createConsOneLeafPerProb()
             idx.push_back( z[i][il] );
         vector< double > coef( idx.size(), 1.0 );
 
-        char rName[256];
-        sprintf( rName, "selLeafProb(%zu)", i );
+        char rName[256] = "";
+        if (storeNames)
+            sprintf( rName, "selLeafProb(%zu)", i );
 
-        lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'E', 1.0 );
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'E', 1.0 );
     }
 }
 
@@ -747,8 +1486,9 @@ void MIPPDtree::createConsSelOneW()
             idx[ia] = w[i][ia];
 
         char rName[256] = "";
-        sprintf(rName, "selAlgProb(%zu)", i);
-        lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'E', 1.0);
+        if (storeNames)
+            sprintf(rName, "selAlgProb(%zu)", i);
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'E', 1.0);
     }
 }
 
@@ -765,10 +1505,11 @@ void MIPPDtree::createConsBranchBeforeLeaf()
             int idx[]     = { l[iln], d[pNodeIdx] };
             double coef[] = { 1.0   , -1.0        };
 
-            char rName[256];
-            sprintf( rName, "branchBeforeL(%s,%s)", leafNodes[iln].c_str(), branchNodes[pNodeIdx].c_str() );
+            char rName[256] = "";
+            if (storeNames)
+                sprintf( rName, "branchBeforeL(%s,%s)", leafNodes[iln].c_str(), branchNodes[pNodeIdx].c_str() );
 
-            lp_add_row( mip, 2, idx, coef, rName, 'L', 0.0 );
+            addRow( 2, idx, coef, rName, 'L', 0.0 );
         } while (pNodeIdx>0);
     }
 }
@@ -778,18 +1519,29 @@ void MIPPDtree::createConsSelAlgLeaf()
     vector< double > coef(nAlgs+1, 1.0);
     vector< int > idx(nAlgs+1);
 
-    *coef.rbegin() = -1.0;
-
-
     for ( size_t il=0 ; (il<nLeafs) ; ++il )
     {
         *idx.rbegin() = l[il];
-        char rName[256]; 
-        sprintf(rName, "selAlgLeaf(%s)", leafNodes[il].c_str());
+        *coef.rbegin() = -1.0;
+        char rName[256] = "";
+        if (storeNames)
+            sprintf(rName, "selAlgLeaf(%s)", leafNodes[il].c_str());
         for ( size_t ia=0 ; (ia<nAlgs); ++ia )
             idx[ia] = c[il][ia];
 
-        lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'E', 0.0);
+        const int maxAlgs = maxLeafAlgs( il );
+        if (maxAlgs==1)
+        {
+            addRow( idx.size(), &idx[0], &coef[0], rName, 'E', 0.0);
+            continue;
+        }
+
+        // a used leaf selects from one to maxAlgs algorithms
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'G', 0.0);
+        *coef.rbegin() = -maxAlgs;
+        if (storeNames)
+            sprintf(rName, "maxAlgLeaf(%s)", leafNodes[il].c_str());
+        addRow( idx.size(), &idx[0], &coef[0], rName, 'L', 0.0);
     }
 }
 
@@ -799,6 +1551,7 @@ void MIPPDtree::setInitialSolution( const Tree *tree )
     
     // which binary variables will be fixed to one
     vector< string > cnames;
+    incFeat = vector< int >( branchNodes.size(), -1 );
     setBinVarsNode(tree->root(), cnames);
     vector< double > ones( cnames.size(), 1.0 );
     char **cns = to_char_vec(cnames);
@@ -808,12 +1561,48 @@ void MIPPDtree::setInitialSolution( const Tree *tree )
     free(cns);
 }
 
+void MIPPDtree::addInitialSolution( const Tree *tree )
+{
+    assert( tree != nullptr );
+
+    // incFeat keeps the branchings of the start of setInitialSolution
+    const vector< int > prevFeat = incFeat;
+    incFeat = vector< int >( branchNodes.size(), -1 );
+    vector< string > cnames;
+    setBinVarsNode(tree->root(), cnames);
+    incFeat = prevFeat;
+
+    vector< double > ones( cnames.size(), 1.0 );
+    char **cns = to_char_vec(cnames);
+    lp_add_mip_start(mip, (int)cnames.size(), (const char **)cns, &ones[0]);
+    free(cns);
+}
+
+int MIPPDtree::mergedAlg( const Node *node ) const
+{
+    if (node->branchFeature()==numeric_limits<size_t>::max())
+        return (int)node->bestAlg();
+
+    // the children of the root are not merged
+    if (node->depth()==0)
+        return -1;
+
+    const int algL = mergedAlg(node->ichild(0));
+    const int algR = mergedAlg(node->ichild(1));
+
+    return (algL==algR) ? algL : -1;
+}
+
 void MIPPDtree::setBinVarsNode( const Node *node, std::vector< std::string > &cnames )
 {
     if (node == nullptr)
         return;
 
-    if (node->branchFeature()!=numeric_limits<size_t>::max())
+    // with symmetry breaking, sibling leafs can not use the same
+    // algorithm: such subtrees are loaded as one leaf, same cost
+    const int alg = Parameters::mipSymmetry ? mergedAlg(node) : -1;
+
+    if (node->branchFeature()!=numeric_limits<size_t>::max() && alg==-1)
     {
         // branch node, setting branching feature
         assert(node->branchFeature()<iset_->features().size());
@@ -821,8 +1610,10 @@ void MIPPDtree::setBinVarsNode( const Node *node, std::vector< std::string > &cn
         char cname[256] = "";
         int idxBN = ((int)(pow(2.0, node->depth())+1e-10))-1 + ((int)node->idx());
         assert( idxBN >=0 && idxBN < (int)branchNodes.size() );
-        assert(a[node->branchFeature()][idxBN]>=0 && a[node->branchFeature()][idxBN]<lp_cols(mip));
-        lp_col_name(mip, a[node->branchFeature()][idxBN], cname);
+        const int idxF = featRep[node->branchFeature()];
+        incFeat[idxBN] = idxF;
+        assert(a[idxF][idxBN]>=0 && a[idxF][idxBN]<lp_cols(mip));
+        lp_col_name(mip, a[idxF][idxBN], cname);
         cnames.push_back(cname);
         setBinVarsNode(node->ichild(0), cnames);
         setBinVarsNode(node->ichild(1), cnames);
@@ -832,19 +1623,23 @@ void MIPPDtree::setBinVarsNode( const Node *node, std::vector< std::string > &cn
         // leaf node, setting best algorithm
         int idxLN = ((int)(pow(2.0, node->depth())+1e-10))-1 + ((int)node->idx()) -1;
         assert( idxLN >=0 && idxLN < (int)leafNodes.size() );
-        int idxBestA = (int)node->bestAlg();
+        int idxBestA = (alg!=-1) ? alg : (int)node->bestAlg();
         int idxC = c[idxLN][idxBestA];
         assert(idxC>=0 && idxC<lp_cols(mip));
         char cname[256] = "";
         lp_col_name(mip, idxC, cname);
         cnames.push_back(cname);
 
-        // setting instances in this node
+        // setting instances in this node, by the
+        // first instance of each group
         for ( int i=0 ; (i<(int)node->n_elements()) ; ++i )
         {
             int idxInst = (int)node->elements()[i];
+            const int idxGroup = iset_->instanceGroup(idxInst);
+            if (iset_->groupInstances(idxGroup)[0] != idxInst)
+                continue;
             char cname[256] = "";
-            lp_col_name(mip, z[idxInst][idxLN], cname);
+            lp_col_name(mip, z[idxGroup][idxLN], cname);
             cnames.push_back(cname);
         }
     }
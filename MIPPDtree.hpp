@@ -27,10 +27,21 @@ class Node;
 class MIPPDtree
 {
 public:
-    MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset );
+    // with _subLevels>0 the tree is the top of a deeper one: each
+    // leaf stands for a subtree with _subLevels more levels, its
+    // cost estimated optimistically (see createConsLnkWCZSubtree)
+    MIPPDtree( const InstanceSet *_iset, const ResultsSet *_rset, const int _subLevels = 0 );
 
     void setInitialSolution( const Tree *tree );
 
+    // one more start, tried by the solver after the one
+    // of setInitialSolution (CPLEX only)
+    void addInitialSolution( const Tree *tree );
+
+    // replaces the initial solution by the one saved in
+    // Parameters::checkpoint, returns false if there is none
+    bool resume();
+
     Tree *build( const int maxSeconds = INT_MAX );
 
     virtual ~MIPPDtree ();
@@ -40,14 +51,42 @@ private:
 
     size_t nLeafs;
 
+    // instances with the same feature ranks are aggregated
+    // in one weighted instance: number of groups
     size_t nInsts;
 
     size_t nFeatures;
 
     size_t nAlgs;
 
+    // levels of the subtrees below the deepest leafs, 0 if none
+    int subLevels;
+
+    // if the lnkWCZ constraints are separated lazily
+    bool lazyLnk;
+
+    // maximum number of algorithms selected in leaf iln: one
+    // or, with subLevels, one per leaf of its subtree
+    int maxLeafAlgs( size_t iln ) const;
+
+    // if row names are generated: only needed
+    // when the model is written or in debug mode
+    bool storeNames;
+
     LinearProgram *mip;
 
+    // rows created so far, in compressed sparse row format,
+    // included in the mip in a single call by flushRows
+    std::vector< int > rStart;
+    std::vector< int > rIdx;
+    std::vector< double > rCoef;
+    std::vector< char > rSense;
+    std::vector< double > rRHS;
+    std::vector< std::string > rNames;
+
+    void addRow( int nz, const int *idx, const double *coef, const char *name, char sense, double rhs );
+    void flushRows();
+
     // penalty for more branches
     static double alpha;
 
@@ -57,6 +96,60 @@ private:
 
     void setBinVarsNode( const Node *node, std::vector< std::string > &cnames );
 
+    // algorithm of all leafs of the subtree of node, if they all
+    // use the same one and node is not the root, -1 otherwise
+    int mergedAlg( const Node *node ) const;
+
+    // optimizes saving each improved solution, returns the status
+    int optimizeAnytime( const int maxSeconds );
+
+    // saves the solution of lp, an improved incumbent, in the
+    // checkpoint and, with anytime, the files of its tree. with lazy
+    // lnkWCZ constraints the solution saved is repaired first
+    void saveIncumbent( LinearProgram *lp, const double secs );
+
+    // saveIncumbent for the copies of mip_race
+    static void raceImproved( LinearProgram *lp, double seconds, void *data );
+
+    // optimizes with the current options (anytime, lazy
+    // constraints), returns the status. the solution found is
+    // stored in solX and solObj
+    int solveModel( const int maxSeconds );
+
+    // valid solution of the last solveModel and its objective value:
+    // with lazy lnkWCZ constraints, if the time limit is reached with
+    // violated ones, the best MIP solution found, repaired
+    std::vector< double > solX;
+    double solObj;
+
+    // objective coefficients of the columns
+    std::vector< double > objCoef;
+
+    // selects again the algorithms of the leafs and instances of x,
+    // a solution whose lnkWCZ constraints may be violated, so that
+    // they are satisfied. returns the objective value of x
+    double repairLnkWCZ( std::vector< double > &x ) const;
+
+    // large neighbourhood search: repeatedly frees the branching
+    // features of one subtree or level, keeping the other ones fixed
+    Tree *buildLNS( const int maxSeconds );
+
+    // branching feature of each branch node in the incumbent, -1 if leaf
+    std::vector< int > incFeat;
+
+    // cost of the last tree saved by optimizeAnytime
+    double savedCost;
+
+    // tree of MIP solution x
+    Tree *treeFromSolution( const double *x );
+
+    // with lazy lnkWCZ constraints, adds the ones violated by x
+    // returning how many were added
+    int separateLnkWCZ( const double *x );
+
+    // lnkWCZ constraints (L and U) already added, per instance and leaf
+    std::vector< char > lazyAdded;
+
     void computeEMax();
 
     std::vector< std::vector< int > > c;
@@ -95,10 +188,23 @@ private:
     void createConsSelectLeaf();
     void createConsOneLeafPerProb();
     void createConsLnkWCZ();
+    void createConsLnkWCZSubtree();
     void createConsSelOneW();
     void createConsBranchBeforeLeaf();
     void createConsSelAlgLeaf();
 
+    // symmetry breaking: children of branched nodes are used and
+    // sibling leafs select different algorithms
+    void createConsChildUsed();
+    void createConsSiblingAlgs();
+
+    // first feature with the same ranks of each feature, with
+    // symmetry breaking only the first one is used in branchings
+    std::vector< int > featRep;
+    void computeFeatRep();
+
+    void setBranchingPriorities();
+
     // names for lp when in debug
     std::vector< std::string > insts;
     std::vector< std::string > algs;
@@ -0,0 +1,137 @@
+/*
+ * MIPRace.cpp
+ */
+
+#include "MIPRace.hpp"
+
+#include <cfloat>
+#include <climits>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <omp.h>
+
+using namespace std;
+
+static const int raceEmphasis[] = { LP_ME_OPTIMALITY, LP_ME_FEASIBILITY, LP_ME_DEFAULT };
+
+int mip_race( LinearProgram **mip, int nRacers, int maxSeconds, int sliceSeconds,
+              race_improved_cb improved, void *data )
+{
+    // each racer has its own solver environment, seed and share of
+    // the cores. the first one keeps the settings of the original
+    // problem, the others also change emphasis and cuts
+    const int nThreads = std::max( 1, omp_get_num_procs()/nRacers );
+    // set when a copy finishes, stopping the optimization of the others
+    volatile int terminate = 0;
+    vector< LinearProgram * > lps;
+    for ( int i=0 ; (i<nRacers) ; ++i )
+    {
+        LinearProgram *lp = lp_clone_own_env( *mip );
+        lp_set_seed( lp, i+1 );
+        lp_set_threads( lp, nThreads );
+        lp_set_terminate( lp, &terminate );
+        if (i>0)
+        {
+            lp_set_mip_emphasis( lp, raceEmphasis[(i-1)%3] );
+            if (((i-1)/3)%2==1)
+                lp_set_cuts( lp, 0 );
+        }
+        lps.push_back( lp );
+    }
+
+    const int nCols = lp_cols( *mip );
+    vector< int > idx( nCols );
+    for ( int j=0 ; (j<nCols) ; ++j )
+        idx[j] = j;
+
+    const double startT = omp_get_wtime();
+    vector< int > st( nRacers, LP_NO_SOL_FOUND );
+
+    // shared incumbent, its racer and the first racer which
+    // finished the optimization, updated in critical sections
+    double bestObj = DBL_MAX;
+    vector< double > bestX;
+    int best = -1;
+    int finished = -1;
+
+#pragma omp parallel for num_threads(nRacers) schedule(static, 1)
+    for ( int i=0 ; i<nRacers ; ++i )
+    {
+        LinearProgram *lp = lps[i];
+        double ownObj = DBL_MAX;
+        while (true)
+        {
+            const double elapsed = omp_get_wtime()-startT;
+            if (maxSeconds!=INT_MAX && elapsed>=maxSeconds)
+                break;
+
+            // starts from the incumbent if found by another racer
+            bool stop = false;
+            vector< double > start;
+            double startObj = DBL_MAX;
+#pragma omp critical(race)
+            {
+                stop = (finished!=-1);
+                if (!stop && best!=i && bestObj<ownObj-1e-9)
+                {
+                    start = bestX;
+                    startObj = bestObj;
+                }
+            }
+            if (stop)
+                break;
+            if (start.size())
+            {
+                lp_load_mip_starti( lp, nCols, &idx[0], &start[0] );
+                ownObj = startObj;
+            }
+
+            int slice = sliceSeconds;
+            if (maxSeconds!=INT_MAX)
+                slice = std::max( 1, std::min( slice, (int)(maxSeconds-elapsed) ) );
+            lp_set_max_seconds( lp, slice );
+            st[i] = lp_optimize( lp );
+
+            const bool hasSol = (st[i]==LP_OPTIMAL || st[i]==LP_FEASIBLE);
+            // optimality, infeasibility or unboundedness proved
+            const bool done = (st[i]!=LP_FEASIBLE && st[i]!=LP_NO_SOL_FOUND);
+#pragma omp critical(race)
+            {
+                if ( hasSol && lp_obj_value(lp)<bestObj-1e-9 )
+                {
+                    bestObj = lp_obj_value( lp );
+                    bestX.assign( lp_x(lp), lp_x(lp)+nCols );
+                    best = i;
+                    cout << "race: solver " << i << " improved objective to " << bestObj << ", " <<
+                        omp_get_wtime()-startT << " seconds" << endl;
+                    if (improved)
+                        improved( lp, omp_get_wtime()-startT, data );
+                }
+                if (done && finished==-1)
+                {
+                    finished = i;
+                    terminate = 1;
+                    cout << "race: solver " << i << " finished the optimization, " <<
+                        omp_get_wtime()-startT << " seconds" << endl;
+                }
+            }
+            if (hasSol)
+                ownObj = std::min( ownObj, lp_obj_value(lp) );
+            if (done)
+                break;
+        }
+    }
+
+    const int winner = (finished!=-1) ? finished : std::max( best, 0 );
+    for ( int i=0 ; (i<nRacers) ; ++i )
+    {
+        lp_set_terminate( lps[i], nullptr );
+        if (i!=winner)
+            lp_free( &lps[i] );
+    }
+    lp_free( mip );
+    *mip = lps[winner];
+
+    return st[winner];
+}
@@ -0,0 +1,31 @@
+/*
+ * MIPRace.hpp
+ */
+
+#ifndef MIPRACE_HPP_
+#define MIPRACE_HPP_
+
+extern "C"
+{
+#include "lp.h"
+}
+
+// called when a copy improves the shared incumbent, with the copy,
+// which has the solution, and the seconds since the race started
+typedef void (*race_improved_cb)( LinearProgram *lp, double seconds, void *data );
+
+// solves nRacers copies of *mip concurrently, each one in its own
+// thread and solver environment, with its own random seed and a
+// share of the cores. copies after the first also change the MIP
+// emphasis and cuts. every sliceSeconds each copy gives its best
+// solution to the shared incumbent and continues from the incumbent
+// if it is better. once a copy finishes the optimization the other
+// ones are interrupted. the race ends after maxSeconds. *mip is
+// replaced by the copy which finished or has the best solution, the
+// other ones are freed. improved, if not null, is called with data
+// for every improved incumbent, one call at a time. returns the
+// status of the copy which replaced *mip
+int mip_race( LinearProgram **mip, int nRacers, int maxSeconds, int sliceSeconds,
+              race_improved_cb improved = nullptr, void *data = nullptr );
+
+#endif /* MIPRACE_HPP_ */
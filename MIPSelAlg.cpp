@@ -11,11 +11,17 @@
 #include "pdtdefines.hpp"
 #include "Tree.hpp"
 #include "Node.hpp"
+#include "MIPRace.hpp"
 #include <vector>
 #include <limits>
 #include <cmath>
 #include <cassert>
 #include <cstring>
+#include <cfloat>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -28,20 +34,19 @@ MIPSelAlg::MIPSelAlg( const ResultsSet *_rset ) :
     iset_(&rset_->instanceSet()),
     nSelAlg_(0),
     selAlg_(new int[_rset->algsettings().size()]),
+    maxAlgs_(Parameters::maxAlgs),
+    rowNAlgs(-1),
     y( new int[rset_->algsettings().size()] ),
-    x( new int*[iset_->size()]),
     mip(lp_create())
 {
-    x[0] = new int[iset_->size()*rset_->algsettings().size()];
-    for ( auto i=1 ; (i<iset_->size()) ; ++i )
-        x[i] = x[i-1] + rset_->algsettings().size();
-
     createYVars();
     createXVars();
     createConsSelK();
     createConsLNKXY();
     createConsSelNAlgs();
     createConsSelMinProbAlg();
+
+    cout << "MIPSelAlg with " << lp_cols(mip) << " columns and " << lp_rows(mip) << " rows" << endl;
 }
 
 void MIPSelAlg::createYVars()
@@ -64,17 +69,39 @@ void MIPSelAlg::createYVars()
 
 void MIPSelAlg::createXVars()
 {
+    const int nAlgs = (int)rset_->algsettings().size();
+    const bool sparse = (Parameters::selAlgTopK>0 && Parameters::selAlgTopK<nAlgs);
+
+    xAlg = vector< vector< int > >(iset_->size());
+    xCol = vector< vector< int > >(iset_->size());
+
     vector< string > cnames;
     vector< double > obj;
     vector< double > lb;
     vector< double > ub;
     for ( auto ip=0 ; ip<iset_->size() ; ++ip )
     {
-        for ( auto ia=0 ; (ia<(int)rset_->algsettings().size()) ; ++ia )
+        if (sparse)
+        {
+            // only the best algorithms (ties included) of
+            // instances where the choice of the algorithm matters
+            if (rset_->stdDevInst(ip)<=MIN_STD_DEV)
+                continue;
+            for ( auto ia=0 ; (ia<nAlgs) ; ++ia )
+                if (rset_->rank(ip, ia)<Parameters::selAlgTopK)
+                    xAlg[ip].push_back(ia);
+        }
+        else
+        {
+            for ( auto ia=0 ; (ia<nAlgs) ; ++ia )
+                xAlg[ip].push_back(ia);
+        }
+
+        for ( const auto ia : xAlg[ip] )
         {
             char cn[256];
             sprintf(cn, "x(%d,%d)", ip, ia);
-            x[ip][ia] = lp_cols(mip)+cnames.size();
+            xCol[ip].push_back(lp_cols(mip)+cnames.size());
             cnames.push_back(cn);
             obj.push_back(rset_->res(ip,ia));
             lb.push_back(0.0);
@@ -87,12 +114,33 @@ void MIPSelAlg::createXVars()
     char **cns = to_char_vec(cnames);
     lp_add_bin_cols(mip, obj.size(), &obj[0], cns);
     free(cns);
+
+    if (!sparse)
+        return;
+
+    // fallback assignments of instances, costing more than
+    // any algorithm, so that the model is always feasible
+    cnames.clear();
+    obj.clear();
+    for ( auto ip=0 ; ip<iset_->size() ; ++ip )
+    {
+        double maxRes = 0.0;
+        for ( auto ia=0 ; (ia<nAlgs) ; ++ia )
+            maxRes = max(maxRes, rset_->res(ip,ia));
+        char cn[256];
+        sprintf(cn, "s(%d)", ip);
+        s.push_back(lp_cols(mip)+cnames.size());
+        cnames.push_back(cn);
+        obj.push_back(maxRes+1.0);
+    }
+    vector< char > isInt(obj.size(), 0);
+    cns = to_char_vec(cnames);
+    lp_add_cols_same_bound(mip, obj.size(), &obj[0], 0.0, Parameters::afMinAlgsInst, &isInt[0], cns);
+    free(cns);
 }
 
 MIPSelAlg::~MIPSelAlg ()
 {
-    delete[] x[0];
-    delete[] x;
     delete[] y;
     delete[] selAlg_;
     lp_free( &mip );
@@ -100,38 +148,45 @@ MIPSelAlg::~MIPSelAlg ()
 
 void MIPSelAlg::createConsSelK()
 {
-    vector< int > idx(rset_->algsettings().size());
-    vector< double > coef(idx.size(), 1.0);
-
     for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
     {
-        for ( size_t ia=0 ; (ia<rset_->algsettings().size()) ; ++ia )
-            idx[ia] = x[ip][ia];
+        vector< int > idx(xCol[ip]);
+        if (s.size())
+            idx.push_back(s[ip]);
+        vector< double > coef(idx.size(), 1.0);
         char rName[256];
         sprintf(rName, "selK(%d)", ip);
-        lp_add_row(mip, rset_->algsettings().size(), &idx[0], &coef[0], rName, 'G', Parameters::afMinAlgsInst);
+        rowSelK.push_back(lp_rows(mip));
+        lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'G', Parameters::afMinAlgsInst);
     }
 }
 
 void MIPSelAlg::createConsLNKXY()
 {
-    for ( size_t ia=0 ; (ia<rset_->algsettings().size()) ; ++ia )
+    const int nAlgs = (int)rset_->algsettings().size();
+
+    // x columns of each algorithm
+    vector< vector< int > > algCols(nAlgs);
+    for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+        for ( size_t j=0 ; (j<xAlg[ip].size()) ; ++j )
+            algCols[xAlg[ip][j]].push_back(xCol[ip][j]);
+
+    for ( int ia=0 ; (ia<nAlgs) ; ++ia )
     {
-        vector< int > idx(iset_->size() + 1);
+        vector< int > idx(algCols[ia]);
+        idx.push_back(y[ia]);
         vector< double  > coef(idx.size(), 1.0);
 
-        for (auto ip=0 ; ip<iset_->size(); ++ip)
-            idx[ip] = x[ip][ia];
-
-        *idx.rbegin() = y[ia];
         *coef.rbegin() = -((double)Parameters::minElementsBranch);
 
         char rName[256];
-        sprintf(rName, "lnkYX(%zu)", ia);
+        sprintf(rName, "lnkYX(%d)", ia);
+        rowLnkYX.push_back(lp_rows(mip));
         lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'G', 0.0);
 
-        sprintf(rName, "lnkXY(%zu)", ia);
+        sprintf(rName, "lnkXY(%d)", ia);
         *coef.rbegin() = -((double)iset_->size());
+        rowLnkXY.push_back(lp_rows(mip));
         lp_add_row( mip, idx.size(), &idx[0], &coef[0], rName, 'L', 0.0);
     }
 }
@@ -146,15 +201,220 @@ void MIPSelAlg::createConsSelNAlgs()
     vector< double > coef(rset_->algsettings().size(), 1.0);
 
     char rName[256]; sprintf(rName, "nAlgs");
-    lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'E', Parameters::maxAlgs);
+    rowNAlgs = lp_rows(mip);
+    lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'E', maxAlgs_);
+}
+
+int MIPSelAlg::xColumn( int ip, int ia ) const
+{
+    for ( size_t j=0 ; (j<xAlg[ip].size()) ; ++j )
+        if (xAlg[ip][j]==ia)
+            return xCol[ip][j];
+    return -1;
+}
+
+void MIPSelAlg::setMaxAlgs( int k )
+{
+    maxAlgs_ = k;
+    lp_set_rhs(mip, rowNAlgs, k);
+
+    if (lastX.empty() || nSelAlg_<=k)
+        return;
+
+    const int nAlgs = (int)rset_->algsettings().size();
+    const double *obj = lp_obj_coef(mip);
+
+    vector< char > inS(nAlgs, 0);
+    for ( int i=0 ; (i<nSelAlg_) ; ++i )
+        inS[selAlg_[i]] = 1;
+
+    // algorithms assigned to each instance, -1 for one unit of slack
+    // added when an algorithm is removed. slack units already used in
+    // the last solution are kept in start
+    vector< vector< int > > assigned(iset_->size());
+    for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+        for ( size_t j=0 ; (j<xAlg[ip].size()) ; ++j )
+            if (lastX[xCol[ip][j]]>=0.5)
+                assigned[ip].push_back(xAlg[ip][j]);
+
+    // cheapest selected algorithm (except ia) not yet assigned to ip
+    auto replacement = [&]( int ip, int ia ) -> int {
+        int best = -1;
+        for ( const auto ib : xAlg[ip] )
+        {
+            if (ib==ia || !inS[ib] || find(assigned[ip].begin(), assigned[ip].end(), ib)!=assigned[ip].end())
+                continue;
+            if (best==-1 || rset_->res(ip,ib)<rset_->res(ip,best))
+                best = ib;
+        }
+        return best;
+    };
+
+    for ( int nS=nSelAlg_ ; (nS>k) ; --nS )
+    {
+        int bestAlg = -1;
+        double bestLoss = DBL_MAX;
+        for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+        {
+            if (!inS[ia])
+                continue;
+            double loss = -((double)Parameters::minElementsBranch)*rset_->avAlg(ia);
+            for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+            {
+                if (find(assigned[ip].begin(), assigned[ip].end(), ia)==assigned[ip].end())
+                    continue;
+                const int ib = replacement(ip, ia);
+                if (ib!=-1)
+                    loss += rset_->res(ip,ib) - rset_->res(ip,ia);
+                else
+                    loss += (s.size() ? obj[s[ip]] : 1e20) - rset_->res(ip,ia);
+            }
+            if (loss<bestLoss)
+            {
+                bestLoss = loss;
+                bestAlg = ia;
+            }
+        }
+
+        inS[bestAlg] = 0;
+        for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+        {
+            auto it = find(assigned[ip].begin(), assigned[ip].end(), bestAlg);
+            if (it!=assigned[ip].end())
+                *it = replacement(ip, bestAlg);
+        }
+    }
+
+    vector< double > start(lp_cols(mip), 0.0);
+    for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+        start[y[ia]] = inS[ia];
+    for ( const auto sc : s )
+        start[sc] = round(lastX[sc]);
+    bool feasible = true;
+    for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+    {
+        for ( const auto ia : assigned[ip] )
+        {
+            if (ia!=-1)
+                start[xColumn(ip, ia)] = 1.0;
+            else if (s.size())
+                start[s[ip]] += 1.0;
+            else
+                feasible = false;
+        }
+    }
+    if (!feasible)
+        return;
+
+    startIdx.clear();
+    startVal.clear();
+    for ( int j=0 ; (j<(int)start.size()) ; ++j )
+    {
+        startIdx.push_back(j);
+        startVal.push_back(start[j]);
+    }
+}
+
+bool MIPSelAlg::resume()
+{
+    const string fileName = checkpointFile();
+    FILE *f = fopen( fileName.c_str(), "r" );
+    if (f == nullptr)
+    {
+        cout << "no checkpoint in " << fileName << ", starting from scratch" << endl;
+        return false;
+    }
+    fclose( f );
+
+    if (lp_read_mip_start( mip, fileName.c_str() )==0)
+        return false;
+
+    // the checkpoint replaces the start derived by setMaxAlgs
+    startIdx.clear();
+    startVal.clear();
+
+    return true;
+}
+
+string MIPSelAlg::checkpointFile() const
+{
+    if (maxAlgs_==Parameters::maxAlgs)
+        return Parameters::checkpoint;
+
+    // other numbers of algorithms: _k<maxAlgs> before the extension
+    const string suffix = "_k" + to_string(maxAlgs_);
+    const size_t pos = Parameters::checkpoint.find_last_of( '.' );
+    if (pos == string::npos || Parameters::checkpoint.find( '/', pos ) != string::npos)
+        return Parameters::checkpoint + suffix;
+
+    return Parameters::checkpoint.substr( 0, pos ) + suffix + Parameters::checkpoint.substr( pos );
+}
+
+void MIPSelAlg::raceImproved( LinearProgram *lp, double seconds, void *data )
+{
+    const MIPSelAlg *msa = (const MIPSelAlg *)data;
+    lp_write_sol_atomic( lp, msa->checkpointFile().c_str() );
+    cout << "checkpoint with objective " << lp_obj_value(lp) << " saved, " << seconds << " seconds" << endl;
+}
+
+int MIPSelAlg::solve( int maxSeconds )
+{
+    int status;
+    if (Parameters::race>1)
+        status = mip_race( &mip, Parameters::race, maxSeconds, Parameters::raceSeconds,
+                           Parameters::checkpoint.size() ? raceImproved : nullptr, this );
+    else if (Parameters::checkpoint.empty())
+    {
+        lp_set_max_seconds(mip, maxSeconds);
+        status = lp_optimize(mip);
+    }
+    else
+    {
+        // optimizes in slices of checkpointSeconds seconds, saving
+        // each improved incumbent: the search is resumed in each call
+        const time_t startT = time(nullptr);
+        double bestObj = DBL_MAX;
+        while (true)
+        {
+            const double elapsed = difftime( time(nullptr), startT );
+            const int slice = (int)std::min( (double)Parameters::checkpointSeconds, maxSeconds-elapsed );
+            lp_set_max_seconds( mip, std::max( slice, 1 ) );
+            status = lp_optimize( mip );
+            if (status!=LP_OPTIMAL && status!=LP_FEASIBLE && status!=LP_NO_SOL_FOUND)
+                break;
+
+            if ( (status==LP_OPTIMAL || status==LP_FEASIBLE) && lp_obj_value(mip)<bestObj-1e-9 )
+            {
+                bestObj = lp_obj_value(mip);
+                lp_write_sol_atomic( mip, checkpointFile().c_str() );
+                cout << "checkpoint with objective " << bestObj << " saved, " <<
+                    difftime( time(nullptr), startT ) << " seconds" << endl;
+            }
+
+            if (status==LP_OPTIMAL || difftime( time(nullptr), startT )>=maxSeconds)
+                break;
+        }
+    }
+
+    return status;
 }
 
 void MIPSelAlg::optimize(int maxSeconds)
 {
-    lp_set_max_seconds(mip, maxSeconds);
-    lp_write_lp(mip, "aaa.lp");
+    if (Parameters::checkpointModel && Parameters::checkpoint.size())
+        lp_write_lp(mip, (checkpointFile()+".lp").c_str());
+    nSelAlg_ = 0;
+    if (s.size())
+        priceXVars();
+    if (startIdx.size())
+    {
+        lp_load_mip_starti(mip, startIdx.size(), &startIdx[0], &startVal[0]);
+        startIdx.clear();
+        startVal.clear();
+    }
     lp_set_mip_emphasis(mip, LP_ME_FEASIBILITY);
-    int status = lp_optimize(mip);
+    const time_t startT = time(nullptr);
+    int status = solve(maxSeconds);
     if (status!=LP_OPTIMAL && status!=LP_FEASIBLE)
     {
         printf("No solution found for MIPSelAlg\n");
@@ -162,6 +422,32 @@ void MIPSelAlg::optimize(int maxSeconds)
     }
 
     double *x = lp_x(mip);
+    lastX.assign(x, x+lp_cols(mip));
+
+    // columns left out by pricing may be needed by instances
+    // falling back to slack: adds them and solves again
+    while (s.size() && addSlackXVars())
+    {
+        const double elapsed = difftime( time(nullptr), startT );
+        if (elapsed>=maxSeconds)
+        {
+            cout << "time limit reached, instances assigned to slack improved only by the new columns" << endl;
+            break;
+        }
+
+        lp_load_mip_starti(mip, startIdx.size(), &startIdx[0], &startVal[0]);
+        startIdx.clear();
+        startVal.clear();
+        status = solve( std::max( 1, (int)(maxSeconds-elapsed) ) );
+        if (status!=LP_OPTIMAL && status!=LP_FEASIBLE)
+            break;
+
+        x = lp_x(mip);
+        lastX.assign(x, x+lp_cols(mip));
+    }
+    startIdx.clear();
+    startVal.clear();
+    x = &lastX[0];
 
     for ( size_t ia=0 ; (ia<rset_->algsettings().size()) ; ++ia )
     {
@@ -171,44 +457,163 @@ void MIPSelAlg::optimize(int maxSeconds)
         selAlg_[nSelAlg_++] = ia;
     }
 
-    assert(nSelAlg_ == Parameters::maxAlgs);
+    assert(nSelAlg_ == maxAlgs_);
 }
 
 void MIPSelAlg::createConsSelMinProbAlg()
 {
-    vector< int > idx(iset_->size()+1);
-    vector< double > coef(idx.size(), 1.0);
-    (*coef.rbegin()) = -Parameters::minElementsBranch;
+    const int nAlgs = (int)rset_->algsettings().size();
+
+    vector< vector< int > > algCols(nAlgs);
+    for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+        for ( size_t j=0 ; (j<xAlg[ip].size()) ; ++j )
+            algCols[xAlg[ip][j]].push_back(xCol[ip][j]);
 
-    for ( auto ia=0 ; (ia<(int)rset_->algsettings().size()) ; ++ia )
+    for ( auto ia=0 ; (ia<nAlgs) ; ++ia )
     {
-        for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
-            idx[ip] = x[ip][ia];
+        vector< int > idx(algCols[ia]);
+        idx.push_back(y[ia]);
+        vector< double > coef(idx.size(), 1.0);
+        (*coef.rbegin()) = -Parameters::minElementsBranch;
 
-        (*idx.rbegin()) = y[ia];
         char rName[256];
         sprintf(rName, "minInstAlg(%d)", ia);
+        rowMinInst.push_back(lp_rows(mip));
         lp_add_row(mip, idx.size(), &idx[0], &coef[0], rName, 'G', 0.0);
     }
 
 }
 
-void MIPSelAlg::saveFilteredResults(const char *fileName) const
+void MIPSelAlg::priceXVars()
+{
+    const int nAlgs = (int)rset_->algsettings().size();
+    vector< char > inModel(nAlgs, 0);
+
+    for ( int round=1 ; ; ++round )
+    {
+        if (lp_optimize_as_continuous(mip)!=LP_OPTIMAL)
+        {
+            cerr << "could not solve the linear relaxation of MIPSelAlg for pricing" << endl;
+            return;
+        }
+        const double *pi = lp_row_price(mip);
+
+        // dual contribution of the rows of each algorithm
+        vector< double > piAlg(nAlgs);
+        for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+            piAlg[ia] = pi[rowLnkYX[ia]] + pi[rowLnkXY[ia]] + pi[rowMinInst[ia]];
+
+        int nAdded = 0;
+        for ( auto ip=0 ; (ip<iset_->size()) ; ++ip )
+        {
+            if (rset_->stdDevInst(ip)<=MIN_STD_DEV)
+                continue;
+
+            for ( const auto ia : xAlg[ip] )
+                inModel[ia] = 1;
+
+            for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+            {
+                if (inModel[ia])
+                    continue;
+                const double rc = rset_->res(ip,ia) - pi[rowSelK[ip]] - piAlg[ia];
+                if (rc >= -1e-6)
+                    continue;
+
+                addXVar(ip, ia);
+                ++nAdded;
+            }
+
+            for ( const auto ia : xAlg[ip] )
+                inModel[ia] = 0;
+        }
+
+        cout << "pricing round " << round << ": lp bound " << lp_obj_value(mip) <<
+            ", " << nAdded << " x columns added" << endl;
+        if (nAdded==0)
+            break;
+    }
+}
+
+void MIPSelAlg::addXVar( int ip, int ia )
 {
-    FILE *f = fopen(fileName, "w");
-    fprintf(f, "instance,algsetting,result\n");
-    for (auto ip=0 ; (ip<iset_->size()) ; ++ip)
+    int idx[] = { rowSelK[ip], rowLnkYX[ia], rowLnkXY[ia], rowMinInst[ia] };
+    double coef[] = { 1.0, 1.0, 1.0, 1.0 };
+    char cn[256];
+    sprintf(cn, "x(%d,%d)", ip, ia);
+    xAlg[ip].push_back(ia);
+    xCol[ip].push_back(lp_cols(mip));
+    lp_add_col(mip, rset_->res(ip,ia), 0.0, 1.0, 1, cn, 4, idx, coef);
+}
+
+int MIPSelAlg::addSlackXVars()
+{
+    const int nAlgs = (int)rset_->algsettings().size();
+
+    // copied, columns are added below
+    const double *obj = lp_obj_coef(mip);
+    vector< double > slackCost;
+    for ( const auto sc : s )
+        slackCost.push_back(obj[sc]);
+
+    vector< int > sel;
+    for ( int ia=0 ; (ia<nAlgs) ; ++ia )
+        if (lastX[y[ia]]>=0.99)
+            sel.push_back(ia);
+
+    // start: the last solution with slack units replaced
+    // by the new columns, cheaper than the slack
+    vector< double > start(lastX);
+    int nAdded = 0, nInsts = 0;
+    double gap = 0.0;
+    for ( auto ip=0 ; ip<iset_->size() ; ++ip )
     {
-        if (rset_->stdDevInst(ip)<=MIN_STD_DEV)
+        if (rset_->stdDevInst(ip)<=MIN_STD_DEV || lastX[s[ip]]<=1e-6)
             continue;
 
-        for (int isa=0 ; (isa<nSelAlg_) ; ++isa)
+        vector< int > missing;
+        for ( const auto ia : sel )
+            if (xColumn(ip, ia)==-1)
+                missing.push_back(ia);
+        if (missing.empty())
+            continue;
+        sort(missing.begin(), missing.end(), [&]( int a1, int a2 ) {
+            return rset_->res(ip,a1)<rset_->res(ip,a2); } );
+
+        ++nInsts;
+        for ( const auto ia : missing )
         {
-            size_t ia = selAlg_[isa];
-            fprintf(f, "%s,%s,%.4f\n", iset_->instance(ip).name(), rset_->algsettings()[ia].c_str(), rset_->res(ip, ia));
+            if (start[s[ip]]<=1e-6)
+                break;
+            addXVar(ip, ia);
+            start.push_back(1.0);
+            gap += slackCost[ip]-rset_->res(ip,ia);
+            start[s[ip]] = std::max(0.0, start[s[ip]]-1.0);
+            ++nAdded;
         }
     }
-    fclose(f);
+
+    if (nAdded==0)
+        return 0;
+
+    cout << nAdded << " x columns of selected algorithms added for " << nInsts <<
+        " instances assigned to slack, solution improved by at least " << gap << endl;
+
+    lastX = start;
+    startIdx.clear();
+    startVal.clear();
+    for ( int j=0 ; (j<(int)start.size()) ; ++j )
+    {
+        startIdx.push_back(j);
+        startVal.push_back(start[j]);
+    }
+
+    return nAdded;
+}
+
+void MIPSelAlg::saveFilteredResults(const char *fileName) const
+{
+    rset_->saveFilteredResults( fileName, nSelAlg_, selAlg_ );
 }
 
 static char **to_char_vec( const vector< string > names )
@@ -8,6 +8,9 @@
 #ifndef MIPSELALG_HPP_
 #define MIPSELALG_HPP_
 
+#include <vector>
+#include <string>
+
 class ResultsSet;
 
 extern "C"
@@ -22,8 +25,18 @@ class MIPSelAlg
 public:
     MIPSelAlg( const ResultsSet *_rset );
 
+    // starts from the solution saved in the checkpoint of the current
+    // number of algorithms instead of the start of setMaxAlgs,
+    // returns false if there is none
+    bool resume();
+
     void optimize(int maxSeconds);
 
+    // changes the number of algorithms to be selected, the next
+    // optimize starts from the last solution without the selected
+    // algorithms whose removal increases the cost the least
+    void setMaxAlgs( int k );
+
     int nSelAlg() const {
         return nSelAlg_;
     }
@@ -42,6 +55,18 @@ private:
     int nSelAlg_;
     int *selAlg_;
 
+    // number of algorithms to be selected, rhs of row nAlgs
+    int maxAlgs_;
+    int rowNAlgs;
+
+    // last solution found and the start for the next optimize
+    std::vector< double > lastX;
+    std::vector< int > startIdx;
+    std::vector< double > startVal;
+
+    // column of x(ip,ia), -1 if not in the model
+    int xColumn( int ip, int ia ) const;
+
     void createYVars();
     void createXVars();
     void createConsSelK();
@@ -49,10 +74,47 @@ private:
     void createConsSelNAlgs();
     void createConsSelMinProbAlg();
 
+    // Parameters::checkpoint, with _k<maxAlgs> before the extension
+    // when selecting other than Parameters::maxAlgs algorithms, so that
+    // each step of a sweep resumes from its own solution
+    std::string checkpointFile() const;
+
+    // saves the improved incumbents of mip_race in the checkpoint
+    static void raceImproved( LinearProgram *lp, double seconds, void *data );
+
+    // with Parameters::selAlgTopK, adds the x columns left out of
+    // the model which have negative reduced cost in the linear
+    // relaxation, until there is none
+    void priceXVars();
+
+    // adds x(ip,ia) to the sparse model
+    void addXVar( int ip, int ia );
+
+    // after a solution of the sparse model is found: adds the missing
+    // x columns of selected algorithms for instances using slack, which
+    // pricing at the root did not add, updating lastX and setting the
+    // improved solution as start. returns the number of columns added
+    int addSlackXVars();
+
+    // solves the MIP with the current settings, returns its status
+    int solve( int maxSeconds );
+
     // y var indexes
     int *y;
 
-    int **x;
+    // x var indexes: algorithms with x vars for each instance and
+    // the corresponding column, all algorithms in the dense model
+    std::vector< std::vector< int > > xAlg;
+    std::vector< std::vector< int > > xCol;
+
+    // slack of selK(i), only in the sparse model
+    std::vector< int > s;
+
+    // rows where x(i,a) appears
+    std::vector< int > rowSelK;
+    std::vector< int > rowLnkYX;
+    std::vector< int > rowLnkXY;
+    std::vector< int > rowMinInst;
 
     LinearProgram *mip;
 };
@@ -0,0 +1,406 @@
+/*
+ * ObliqueSplit.cpp
+ */
+
+#include "ObliqueSplit.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <omp.h>
+
+#include "InstanceSet.hpp"
+#include "ResultsSet.hpp"
+#include "Parameters.hpp"
+
+using namespace std;
+
+// projections smaller than this are considered zero
+#define OS_EPS 1e-12
+
+struct ObliqueSplit::SearchData
+{
+    SearchData( size_t nEl, size_t nAlgs ) :
+        proj(nEl),
+        dir(nEl),
+        sumR(nAlgs)
+    {
+        events.reserve(nEl);
+    }
+
+    std::vector< double > proj;
+    std::vector< double > dir;
+
+    // alpha where each element changes its side
+    std::vector< std::pair< double, int > > events;
+
+    // sum of results of each algorithm in the right side
+    std::vector< double > sumR;
+};
+
+ObliqueSplit::ObliqueSplit( const InstanceSet *_iset, const ResultsSet *_rset ) :
+    iset_(_iset),
+    rset_(_rset),
+    nFeat(_iset->features().size()),
+    nAlgs(_rset->algsettings().size()),
+    nThreads((Parameters::threads>=1) ? Parameters::threads : omp_get_num_procs()),
+    gFeat(new double[_iset->nGroups()*_iset->features().size()]),
+    totRes(_rset->algsettings().size()),
+    totWeight(0),
+    coef_(_iset->features().size(), 0.0),
+    rhs_(0.0),
+    cost_(DBL_MAX),
+    axisCost_(DBL_MAX),
+    sdata(new SearchData*[nThreads])
+{
+    bestAlg_[0] = bestAlg_[1] = -1;
+
+    for ( int ig=0 ; (ig<iset_->nGroups()) ; ++ig )
+    {
+        const int idxInst = iset_->groupInstances(ig)[0];
+        for ( size_t f=0 ; (f<nFeat) ; ++f )
+            gFeat[ig*nFeat+f] = iset_->norm_feature_val_rank(idxInst, f);
+    }
+
+    for ( int t=0 ; (t<nThreads) ; ++t )
+        sdata[t] = new SearchData(iset_->nGroups(), nAlgs);
+}
+
+int ObliqueSplit::side( int idxInst ) const
+{
+    const double *x = gFeat + iset_->instanceGroup(idxInst)*nFeat;
+    double v = -rhs_;
+    for ( size_t f=0 ; (f<nFeat) ; ++f )
+        v += coef_[f]*x[f];
+
+    return (v>0.0) ? 1 : 0;
+}
+
+double ObliqueSplit::evaluate( SearchData *sd, const double *proj, int *algs ) const
+{
+    fill( sd->sumR.begin(), sd->sumR.end(), 0.0 );
+    int wR = 0;
+    for ( size_t j=0 ; (j<elGroup.size()) ; ++j )
+    {
+        if (proj[j]<=0.0)
+            continue;
+        wR += elWeight[j];
+        const double *r = &elRes[j*nAlgs];
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            sd->sumR[ia] += r[ia];
+    }
+
+    if (wR<(int)Parameters::minElementsBranch || totWeight-wR<(int)Parameters::minElementsBranch)
+        return DBL_MAX;
+
+    double minL = DBL_MAX, minR = DBL_MAX;
+    for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+    {
+        if (totRes[ia]-sd->sumR[ia]<minL)
+        {
+            minL = totRes[ia]-sd->sumR[ia];
+            algs[0] = ia;
+        }
+        if (sd->sumR[ia]<minR)
+        {
+            minR = sd->sumR[ia];
+            algs[1] = ia;
+        }
+    }
+
+    return minL + minR;
+}
+
+double ObliqueSplit::lineSearch( SearchData *sd, const double *proj, const double *dir, double *alpha ) const
+{
+    const size_t nEl = elGroup.size();
+    const int minEl = (int)Parameters::minElementsBranch;
+
+    // right side for alpha smaller than all events: elements with negative
+    // direction and the ones which do not move and are in the right
+    auto &events = sd->events;
+    events.clear();
+    fill( sd->sumR.begin(), sd->sumR.end(), 0.0 );
+    int wR = 0;
+    for ( size_t j=0 ; (j<nEl) ; ++j )
+    {
+        if (fabs(dir[j])>OS_EPS)
+            events.push_back( make_pair( -proj[j]/dir[j], (int)j ) );
+        if (dir[j]<-OS_EPS || (fabs(dir[j])<=OS_EPS && proj[j]>0.0))
+        {
+            wR += elWeight[j];
+            const double *r = &elRes[j*nAlgs];
+            for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+                sd->sumR[ia] += r[ia];
+        }
+    }
+    sort( events.begin(), events.end() );
+
+    double bestCost = DBL_MAX;
+    *alpha = 0.0;
+    double *sumR = &sd->sumR[0];
+    const double *tot = &totRes[0];
+
+    auto update = [&]( double c, double a ) {
+        if (c<bestCost-1e-9 || (c<bestCost+1e-9 && fabs(a)<fabs(*alpha)))
+        {
+            bestCost = c;
+            *alpha = a;
+        }
+    };
+
+    auto valid = [&]( int w ) {
+        return w>=minEl && totWeight-w>=minEl;
+    };
+
+    if (valid( wR ))
+    {
+        double minL = DBL_MAX, minR = DBL_MAX;
+        for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+        {
+            minL = min( minL, tot[ia]-sumR[ia] );
+            minR = min( minR, sumR[ia] );
+        }
+        update( minL+minR, events.empty() ? 0.0 : events[0].first-1.0 );
+    }
+
+    for ( size_t k=0 ; (k<events.size()) ; )
+    {
+        // all elements changing side at the same alpha, the cost
+        // is computed while the last one is moved
+        const double t = events[k].first;
+        size_t kEnd = k;
+        while (kEnd<events.size() && events[kEnd].first<=t)
+            ++kEnd;
+
+        for ( ; (k<kEnd) ; ++k )
+        {
+            const int j = events[k].second;
+            const double *r = &elRes[j*nAlgs];
+            const double sign = (dir[j]>0.0) ? 1.0 : -1.0;
+            wR += (dir[j]>0.0) ? elWeight[j] : -elWeight[j];
+            if (k+1<kEnd || !valid( wR ))
+            {
+                for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+                    sumR[ia] += sign*r[ia];
+                continue;
+            }
+
+            double minL = DBL_MAX, minR = DBL_MAX;
+            for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            {
+                sumR[ia] += sign*r[ia];
+                minL = min( minL, tot[ia]-sumR[ia] );
+                minR = min( minR, sumR[ia] );
+            }
+            const double next = (kEnd<events.size()) ? events[kEnd].first : t+2.0;
+            update( minL+minR, (t+next)/2.0 );
+        }
+    }
+
+    return bestCost;
+}
+
+double ObliqueSplit::improve( SearchData *sd, vector< double > &w, double &bias, unsigned int seed, double endTime ) const
+{
+    const size_t nEl = elGroup.size();
+    double *proj = &sd->proj[0];
+    double *dir = &sd->dir[0];
+
+    for ( size_t j=0 ; (j<nEl) ; ++j )
+    {
+        const double *x = gFeat + elGroup[j]*nFeat;
+        proj[j] = bias;
+        for ( size_t f=0 ; (f<nFeat) ; ++f )
+            proj[j] += w[f]*x[f];
+    }
+    int algs[2];
+    double cur = evaluate( sd, proj, algs );
+
+    std::mt19937 rng( seed );
+    std::normal_distribution< double > normal( 0.0, 1.0 );
+    vector< double > rdir( nFeat+1 );
+
+    // number of random directions tried when no coefficient improves
+    const int nJumps = 5;
+
+    while (omp_get_wtime()<endTime)
+    {
+        bool improved = false;
+
+        // coefficient of each feature and then the bias
+        for ( size_t m=0 ; (m<=nFeat) ; ++m )
+        {
+            for ( size_t j=0 ; (j<nEl) ; ++j )
+                dir[j] = (m<nFeat) ? gFeat[elGroup[j]*nFeat+m] : 1.0;
+
+            double alpha;
+            const double c = lineSearch( sd, proj, dir, &alpha );
+            if (c<cur-1e-9)
+            {
+                if (m<nFeat)
+                    w[m] += alpha;
+                else
+                    bias += alpha;
+                for ( size_t j=0 ; (j<nEl) ; ++j )
+                    proj[j] += alpha*dir[j];
+                cur = c;
+                improved = true;
+            }
+        }
+
+        if (improved)
+            continue;
+
+        // local optimum for all coefficients: random directions
+        for ( int r=0 ; (r<nJumps && !improved) ; ++r )
+        {
+            for ( auto &v : rdir )
+                v = normal( rng );
+            for ( size_t j=0 ; (j<nEl) ; ++j )
+            {
+                const double *x = gFeat + elGroup[j]*nFeat;
+                dir[j] = rdir[nFeat];
+                for ( size_t f=0 ; (f<nFeat) ; ++f )
+                    dir[j] += rdir[f]*x[f];
+            }
+
+            double alpha;
+            const double c = lineSearch( sd, proj, dir, &alpha );
+            if (c<cur-1e-9)
+            {
+                for ( size_t f=0 ; (f<nFeat) ; ++f )
+                    w[f] += alpha*rdir[f];
+                bias += alpha*rdir[nFeat];
+                for ( size_t j=0 ; (j<nEl) ; ++j )
+                    proj[j] += alpha*dir[j];
+                cur = c;
+                improved = true;
+            }
+        }
+
+        if (!improved)
+            break;
+    }
+
+    return cur;
+}
+
+bool ObliqueSplit::search( const vector< int > &insts, double maxSeconds )
+{
+    const double endTime = omp_get_wtime() + maxSeconds;
+
+    // elements: groups of the instances
+    elGroup.clear();
+    elWeight.clear();
+    elRes.clear();
+    fill( totRes.begin(), totRes.end(), 0.0 );
+    totWeight = 0;
+    {
+        vector< int > elOfGroup( iset_->nGroups(), -1 );
+        const size_t n = insts.size() ? insts.size() : (size_t)iset_->size();
+        for ( size_t k=0 ; (k<n) ; ++k )
+        {
+            const int i = insts.size() ? insts[k] : (int)k;
+            const int g = iset_->instanceGroup(i);
+            if (elOfGroup[g]==-1)
+            {
+                elOfGroup[g] = elGroup.size();
+                elGroup.push_back( g );
+                elWeight.push_back( 0 );
+                elRes.resize( elRes.size()+nAlgs, 0.0 );
+            }
+            const int j = elOfGroup[g];
+            ++elWeight[j];
+            ++totWeight;
+            double *r = &elRes[j*nAlgs];
+            for ( size_t ia=0 ; (ia<nAlgs) ; ++ia )
+            {
+                r[ia] += rset_->res(i, ia);
+                totRes[ia] += rset_->res(i, ia);
+            }
+        }
+    }
+    const size_t nEl = elGroup.size();
+
+    // exact axis parallel split of each feature: x[f] + bias > 0
+    vector< pair< double, int > > axis( nFeat );
+    vector< double > axisBias( nFeat, 0.0 );
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+    for ( int f=0 ; f<(int)nFeat ; ++f )
+    {
+        SearchData *sd = sdata[omp_get_thread_num()];
+        for ( size_t j=0 ; (j<nEl) ; ++j )
+        {
+            sd->proj[j] = gFeat[elGroup[j]*nFeat+f];
+            sd->dir[j] = 1.0;
+        }
+        axis[f] = make_pair( lineSearch( sd, &sd->proj[0], &sd->dir[0], &axisBias[f] ), f );
+    }
+    sort( axis.begin(), axis.end() );
+
+    axisCost_ = axis[0].first;
+    if (axisCost_==DBL_MAX)
+    {
+        cost_ = DBL_MAX;
+        return false;
+    }
+
+    size_t nValid = 0;
+    while (nValid<nFeat && axis[nValid].first<DBL_MAX)
+        ++nValid;
+
+    // even restarts begin at the axis parallel splits of the best
+    // features, odd ones at random perturbations of them
+    const int nRestarts = max( 1, Parameters::obliqueRestarts );
+    vector< vector< double > > rw( nRestarts, vector< double >( nFeat, 0.0 ) );
+    vector< double > rb( nRestarts, 0.0 );
+    vector< double > rc( nRestarts, DBL_MAX );
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+    for ( int r=0 ; r<nRestarts ; ++r )
+    {
+        SearchData *sd = sdata[omp_get_thread_num()];
+        const int f = axis[(r/2)%nValid].second;
+        rw[r][f] = 1.0;
+        rb[r] = axisBias[f];
+        if (r%2)
+        {
+            std::mt19937 rng( r );
+            std::normal_distribution< double > normal( 0.0, 0.25 );
+            for ( auto &v : rw[r] )
+                v += normal( rng );
+        }
+        rc[r] = improve( sd, rw[r], rb[r], (unsigned int)r+1, endTime );
+    }
+
+    int best = 0;
+    for ( int r=1 ; (r<nRestarts) ; ++r )
+        if (rc[r]<rc[best])
+            best = r;
+
+    coef_ = rw[best];
+    rhs_ = -rb[best];
+
+    SearchData *sd = sdata[0];
+    for ( size_t j=0 ; (j<nEl) ; ++j )
+    {
+        const double *x = gFeat + elGroup[j]*nFeat;
+        sd->proj[j] = -rhs_;
+        for ( size_t f=0 ; (f<nFeat) ; ++f )
+            sd->proj[j] += coef_[f]*x[f];
+    }
+    cost_ = evaluate( sd, &sd->proj[0], bestAlg_ );
+
+    return cost_<DBL_MAX;
+}
+
+ObliqueSplit::~ObliqueSplit ()
+{
+    for ( int t=0 ; (t<nThreads) ; ++t )
+        delete sdata[t];
+    delete[] sdata;
+    delete[] gFeat;
+}
@@ -0,0 +1,99 @@
+/*
+ * ObliqueSplit.hpp
+ */
+
+#ifndef OBLIQUESPLIT_HPP_
+#define OBLIQUESPLIT_HPP_
+
+class InstanceSet;
+class ResultsSet;
+
+#include <cstddef>
+#include <vector>
+
+// search of the best oblique split of a set of instances, without the
+// MIP of MIPMultiVariate: the hyperplane sum_f coef[f]*x[f] > rhs, over
+// the normalized feature ranks, sends instances to the right. each side
+// uses its cheapest algorithm. starting from the exact axis parallel
+// splits, coefficients are improved OC1-style: exact line searches on
+// each coefficient and on random directions, from several restarts
+// processed in parallel
+class ObliqueSplit
+{
+public:
+    ObliqueSplit( const InstanceSet *_iset, const ResultsSet *_rset );
+
+    // searches the best split of insts (all instances if empty), returns
+    // false if no split has at least minElementsBranch instances in both
+    // sides. the search is stopped after maxSeconds
+    bool search( const std::vector< int > &insts, double maxSeconds );
+
+    const std::vector< double > &coef() const {
+        return coef_;
+    }
+
+    double rhs() const {
+        return rhs_;
+    }
+
+    // 1 if instance idxInst goes to the right with the current split
+    int side( int idxInst ) const;
+
+    // sum of the results of the best algorithm of each side
+    double cost() const {
+        return cost_;
+    }
+
+    // cost of the best axis parallel split
+    double axisCost() const {
+        return axisCost_;
+    }
+
+    // cheapest algorithm of each side
+    int bestAlg( int side ) const {
+        return bestAlg_[side];
+    }
+
+    virtual ~ObliqueSplit ();
+private:
+    const InstanceSet *iset_;
+    const ResultsSet *rset_;
+
+    size_t nFeat;
+    size_t nAlgs;
+    int nThreads;
+
+    // instances with the same feature ranks are searched as one
+    // weighted element: normalized ranks of each group
+    double *gFeat;
+
+    // elements of the current search: group, weight and
+    // sum of the results of each algorithm
+    std::vector< int > elGroup;
+    std::vector< int > elWeight;
+    std::vector< double > elRes;
+    std::vector< double > totRes;
+    int totWeight;
+
+    std::vector< double > coef_;
+    double rhs_;
+    double cost_;
+    double axisCost_;
+    int bestAlg_[2];
+
+    // thread work area
+    struct SearchData;
+    SearchData **sdata;
+
+    // cost of the split with projections proj (right if > 0)
+    double evaluate( SearchData *sd, const double *proj, int *algs ) const;
+
+    // best alpha for projections proj+alpha*dir, returns its cost,
+    // DBL_MAX if no valid split exists
+    double lineSearch( SearchData *sd, const double *proj, const double *dir, double *alpha ) const;
+
+    // improves the split (w, bias) from one start, returning its cost
+    double improve( SearchData *sd, std::vector< double > &w, double &bias, unsigned int seed, double endTime ) const;
+};
+
+#endif /* OBLIQUESPLIT_HPP_ */
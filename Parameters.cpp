@@ -45,10 +45,72 @@ double Parameters::fillMissingValue = 999999999;
 
 int Parameters::maxAlgs = 100;
 
+int Parameters::minAlgs = 0;
+
+bool Parameters::selAlgPipeline = false;
+
+double Parameters::selAlgFraction = 0.25;
+
+int Parameters::obliqueRestarts = 8;
+
 int Parameters::afMinAlgsInst = 5;
 
 bool Parameters::onlyGreedy = false;
 
+bool Parameters::exactDP = false;
+
+int Parameters::anytime = 0;
+
+bool Parameters::lazyLnkWCZ = false;
+
+bool Parameters::mipSymmetry = false;
+
+bool Parameters::mipPriorities = false;
+
+int Parameters::lns = 0;
+
+int Parameters::lnsParallel = 0;
+
+int Parameters::hybridLevels = 0;
+
+double Parameters::hybridMIPFraction = 0.5;
+
+bool Parameters::hybridEstimate = true;
+
+bool Parameters::iterDeepening = false;
+
+string Parameters::checkpoint = "";
+
+int Parameters::checkpointSeconds = 60;
+
+bool Parameters::checkpointModel = false;
+
+bool Parameters::resume = false;
+
+int Parameters::race = 0;
+
+int Parameters::raceSeconds = 10;
+
+int Parameters::coreset = 0;
+
+bool Parameters::selAlgHeur = false;
+
+int Parameters::selAlgLagIt = 0;
+
+int Parameters::selAlgTopK = 0;
+
+int Parameters::threads = 1;
+
+bool Parameters::greedyBreadthFirst = false;
+
+int Parameters::greedyBins = 0;
+
+int Parameters::greedyCandAlgs = 0;
+
+int Parameters::greedyPortfolio = 0;
+
+int Parameters::greedyStarts = 1;
+
 enum Evaluation Parameters::eval = Rank;
 
 bool Parameters::bestIsZero = false;
@@ -209,6 +271,26 @@ void Parameters::parse( int argc, const char **argv )
             Parameters::maxAlgs = stoi(string(pValue));
             continue;
         }
+        if (strcasecmp(pName, "-minAlgs")==0)
+        {
+            Parameters::minAlgs = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-selAlgPipeline")==0)
+        {
+            Parameters::selAlgPipeline = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-selAlgFraction")==0)
+        {
+            Parameters::selAlgFraction = stod(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-obliqueRestarts")==0)
+        {
+            Parameters::obliqueRestarts = stoi(string(pValue));
+            continue;
+        }
         if (strcasecmp(pName, "-afMinAlgsInst")==0)
         {
             Parameters::afMinAlgsInst = stoi(string(pValue));
@@ -230,6 +312,171 @@ void Parameters::parse( int argc, const char **argv )
             Parameters::onlyGreedy = (bool)atoi(pValue);
             continue;
         }
+        if (strcasecmp(pName, "-exactDP")==0)
+        {
+            Parameters::exactDP = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-anytime")==0)
+        {
+            Parameters::anytime = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-lazyLnkWCZ")==0)
+        {
+            Parameters::lazyLnkWCZ = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-mipSymmetry")==0)
+        {
+            Parameters::mipSymmetry = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-mipPriorities")==0)
+        {
+            Parameters::mipPriorities = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-lns")==0)
+        {
+            Parameters::lns = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-lnsParallel")==0)
+        {
+            Parameters::lnsParallel = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-hybridLevels")==0)
+        {
+            Parameters::hybridLevels = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-hybridMIPFraction")==0)
+        {
+            Parameters::hybridMIPFraction = stod(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-hybridEstimate")==0)
+        {
+            Parameters::hybridEstimate = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-iterDeepening")==0)
+        {
+            Parameters::iterDeepening = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-checkpoint")==0)
+        {
+            Parameters::checkpoint = string(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-checkpointSeconds")==0)
+        {
+            Parameters::checkpointSeconds = stoi(string(pValue));
+            if (Parameters::checkpointSeconds<1)
+            {
+                cerr << "checkpointSeconds should be at least 1" << endl;
+                abort();
+            }
+            continue;
+        }
+        if (strcasecmp(pName, "-checkpointModel")==0)
+        {
+            Parameters::checkpointModel = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-resume")==0)
+        {
+            Parameters::resume = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-race")==0)
+        {
+            Parameters::race = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-selAlgHeur")==0)
+        {
+            Parameters::selAlgHeur = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-selAlgLagIt")==0)
+        {
+            Parameters::selAlgLagIt = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-selAlgTopK")==0)
+        {
+            Parameters::selAlgTopK = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-coreset")==0)
+        {
+            Parameters::coreset = stoi(string(pValue));
+            continue;
+        }
+        if (strcasecmp(pName, "-raceSeconds")==0)
+        {
+            Parameters::raceSeconds = stoi(string(pValue));
+            if (Parameters::raceSeconds<1)
+            {
+                cerr << "raceSeconds should be at least 1" << endl;
+                abort();
+            }
+            continue;
+        }
+        if (strcasecmp(pName, "-greedyBreadthFirst")==0)
+        {
+            Parameters::greedyBreadthFirst = (bool)atoi(pValue);
+            continue;
+        }
+        if (strcasecmp(pName, "-greedyBins")==0)
+        {
+            Parameters::greedyBins = stoi(string(pValue));
+            if (greedyBins<0 || greedyBins>256)
+            {
+                cerr << "Number of bins should be in [0,256]" << endl;
+                abort();
+            }
+            continue;
+        }
+        if (strcasecmp(pName, "-greedyCandAlgs")==0)
+        {
+            Parameters::greedyCandAlgs = stoi(string(pValue));
+            if (greedyCandAlgs<0)
+            {
+                cerr << "Number of candidate algorithms should be >= 0" << endl;
+                abort();
+            }
+            continue;
+        }
+        if (strcasecmp(pName, "-greedyPortfolio")==0)
+        {
+            Parameters::greedyPortfolio = stoi(string(pValue));
+            if (greedyPortfolio<0)
+            {
+                cerr << "Number of randomized greedy trees should be >= 0" << endl;
+                abort();
+            }
+            continue;
+        }
+        if (strcasecmp(pName, "-greedyStarts")==0)
+        {
+            Parameters::greedyStarts = stoi(string(pValue));
+            if (greedyStarts<1)
+            {
+                cerr << "Number of greedy trees loaded as MIP starts should be >= 1" << endl;
+                abort();
+            }
+            continue;
+        }
+        if (strcasecmp(pName, "-threads")==0)
+        {
+            Parameters::threads = stoi(string(pValue));
+            continue;
+        }
  
         if (strcasecmp(pName, "-normalizeResults")==0)
         {
@@ -329,6 +576,37 @@ void Parameters::help()
     cout << "\t-maxDepth=int" << endl;
     cout << "\t-minPerfImprov=double" << endl;
     cout << "\t-minAbsPerfImprov=double" << endl;
+    cout << "\t-exactDP=[0,1]" << endl;
+    cout << "\t-anytime=int" << endl;
+    cout << "\t-lazyLnkWCZ=[0,1]" << endl;
+    cout << "\t-mipSymmetry=[0,1]" << endl;
+    cout << "\t-mipPriorities=[0,1]" << endl;
+    cout << "\t-lns=int" << endl;
+    cout << "\t-lnsParallel=int" << endl;
+    cout << "\t-hybridLevels=int" << endl;
+    cout << "\t-hybridMIPFraction=float" << endl;
+    cout << "\t-hybridEstimate=[0,1]" << endl;
+    cout << "\t-iterDeepening=[0,1] (the model of each depth is rebuilt, started from the previous tree)" << endl;
+    cout << "\t-checkpoint=fileName" << endl;
+    cout << "\t-checkpointSeconds=int" << endl;
+    cout << "\t-checkpointModel=[0,1]" << endl;
+    cout << "\t-resume=[0,1]" << endl;
+    cout << "\t-race=int" << endl;
+    cout << "\t-raceSeconds=int" << endl;
+    cout << "\t-coreset=int" << endl;
+    cout << "\t-selAlgHeur=[0,1]" << endl;
+    cout << "\t-selAlgLagIt=int" << endl;
+    cout << "\t-selAlgTopK=int" << endl;
+    cout << "\t-minAlgs=int" << endl;
+    cout << "\t-selAlgPipeline=[0,1]" << endl;
+    cout << "\t-selAlgFraction=float" << endl;
+    cout << "\t-obliqueRestarts=int" << endl;
+    cout << "\t-threads=int" << endl;
+    cout << "\t-greedyBreadthFirst=[0,1]" << endl;
+    cout << "\t-greedyBins=[0,...,256]" << endl;
+    cout << "\t-greedyCandAlgs=int" << endl;
+    cout << "\t-greedyPortfolio=int" << endl;
+    cout << "\t-greedyStarts=int" << endl;
 
 }
 
@@ -340,6 +618,37 @@ void Parameters::print()
     cout << "                 eval=" << EvaluationStr[Parameters::eval] << endl;
     cout << "           bestIsZero=" << Parameters::bestIsZero << endl;
     cout << "           onlyGreedy=" << Parameters::onlyGreedy << endl;
+    cout << "              exactDP=" << Parameters::exactDP << endl;
+    cout << "              anytime=" << Parameters::anytime << endl;
+    cout << "           lazyLnkWCZ=" << Parameters::lazyLnkWCZ << endl;
+    cout << "          mipSymmetry=" << Parameters::mipSymmetry << endl;
+    cout << "        mipPriorities=" << Parameters::mipPriorities << endl;
+    cout << "                  lns=" << Parameters::lns << endl;
+    cout << "          lnsParallel=" << Parameters::lnsParallel << endl;
+    cout << "         hybridLevels=" << Parameters::hybridLevels << endl;
+    cout << "    hybridMIPFraction=" << Parameters::hybridMIPFraction << endl;
+    cout << "       hybridEstimate=" << Parameters::hybridEstimate << endl;
+    cout << "        iterDeepening=" << Parameters::iterDeepening << endl;
+    cout << "           checkpoint=" << Parameters::checkpoint << endl;
+    cout << "    checkpointSeconds=" << Parameters::checkpointSeconds << endl;
+    cout << "      checkpointModel=" << Parameters::checkpointModel << endl;
+    cout << "               resume=" << Parameters::resume << endl;
+    cout << "                 race=" << Parameters::race << endl;
+    cout << "          raceSeconds=" << Parameters::raceSeconds << endl;
+    cout << "              coreset=" << Parameters::coreset << endl;
+    cout << "           selAlgHeur=" << Parameters::selAlgHeur << endl;
+    cout << "          selAlgLagIt=" << Parameters::selAlgLagIt << endl;
+    cout << "           selAlgTopK=" << Parameters::selAlgTopK << endl;
+    cout << "              minAlgs=" << Parameters::minAlgs << endl;
+    cout << "       selAlgPipeline=" << Parameters::selAlgPipeline << endl;
+    cout << "       selAlgFraction=" << Parameters::selAlgFraction << endl;
+    cout << "      obliqueRestarts=" << Parameters::obliqueRestarts << endl;
+    cout << "              threads=" << Parameters::threads << endl;
+    cout << "   greedyBreadthFirst=" << Parameters::greedyBreadthFirst << endl;
+    cout << "           greedyBins=" << Parameters::greedyBins << endl;
+    cout << "       greedyCandAlgs=" << Parameters::greedyCandAlgs << endl;
+    cout << "      greedyPortfolio=" << Parameters::greedyPortfolio << endl;
+    cout << "         greedyStarts=" << Parameters::greedyStarts << endl;
     cout << "     normalizeResults=" << Parameters::normalizeResults << endl;
     cout << "             maxDepth=" << Parameters::maxDepth << endl;
     cout << "              rankEps=" << scientific << rankEps << endl;
@@ -118,6 +118,21 @@ public:
     // how many select
     static int maxAlgs;
 
+    // if >0, selalg solves for maxAlgs, maxAlgs-1, ..., minAlgs
+    // algorithms, each one starting from the previous solution
+    static int minAlgs;
+
+    // if mpdt first selects maxAlgs algorithms, as selalg does,
+    // and builds the tree with the results of these only
+    static bool selAlgPipeline;
+
+    // fraction of maxSeconds given to the algorithm selection of
+    // selAlgPipeline, the tree is built in the time left
+    static double selAlgFraction;
+
+    // random restarts of the oblique split search (ObliqueSplit)
+    static int obliqueRestarts;
+
     // in the algorithm filter, minimum number 
     // of algorithm configurations for
     // covering each problem instance
@@ -125,6 +140,115 @@ public:
 
     // if only the greedy algorithm will be executed
     static bool onlyGreedy;
+
+    // if the optimal tree is computed by the dynamic
+    // programming solver instead of the MIP solver
+    static bool exactDP;
+
+    // if >0, every improved tree found by the exact solvers is saved
+    // in treeFile/treeFileGV; the MIP solver checks its incumbent
+    // after every anytime seconds
+    static int anytime;
+
+    // if the lnkWCZ constraints of the MIP are not included in the
+    // initial formulation, but only when violated by some solution
+    static bool lazyLnkWCZ;
+
+    // symmetry breaking constraints in the MIP
+    static bool mipSymmetry;
+
+    // if the MIP solver branches first on branch/leaf (d)
+    // variables, then on features (a) and then on leafs (z)
+    static bool mipPriorities;
+
+    // if >0, the MIP is solved by large neighbourhood search,
+    // with at most lns seconds per neighbourhood
+    static int lns;
+
+    // neighbourhoods of lns solved concurrently, each one with an
+    // equal share of the cores, 0 for one per core
+    static int lnsParallel;
+
+    // if >0 and smaller than maxDepth-1, the MIP solver builds only
+    // the first hybridLevels branching levels and the subtrees of its
+    // leafs are built in parallel by the dynamic programming solver
+    static int hybridLevels;
+
+    // fraction of maxSeconds given to the MIP of the first
+    // hybridLevels levels, the rest is left to the subtrees
+    static double hybridMIPFraction;
+
+    // if the MIP of the first hybridLevels levels estimates the cost of
+    // the subtree of each leaf optimistically, selecting one algorithm
+    // per leaf of the subtree, instead of a single algorithm per leaf
+    static bool hybridEstimate;
+
+    // if the MIP is solved for maxDepth 2, 3, ... up to maxDepth,
+    // each tree being the initial solution of the next depth. the
+    // model of each depth is built from scratch, each depth gets a
+    // share of the time left proportional to its number of leafs
+    static bool iterDeepening;
+
+    // if not empty, the incumbent of the MIP solvers is saved in this
+    // file every time it improves, checked every checkpointSeconds.
+    // with checkpointModel the model is also saved, in checkpoint.lp.
+    // in a selalg sweep, steps after maxAlgs use checkpoint_k<k>
+    static std::string checkpoint;
+    static int checkpointSeconds;
+    static bool checkpointModel;
+
+    // if the MIP solvers start from the solution in checkpoint
+    static bool resume;
+
+    // if >1, the MIP solvers race this number of copies of the model
+    // concurrently, with different seeds and settings, sharing the best
+    // solution every raceSeconds seconds. improved solutions of the
+    // race are saved as with anytime and checkpoint
+    static int race;
+    static int raceSeconds;
+
+    // if >0, the MIP is solved for a coreset with this number of
+    // weighted instances (at least one per best algorithm) and the
+    // thresholds of its tree are then refined with all instances.
+    // ignored with exactDP, hybridLevels and iterDeepening
+    static int coreset;
+
+    // if selalg uses the native heuristic (HeurSelAlg) instead
+    // of the MIP, with selAlgLagIt iterations of the lagrangean
+    // lower bound after the local search
+    static bool selAlgHeur;
+    static int selAlgLagIt;
+
+    // if >0, MIPSelAlg only creates x vars for the selAlgTopK best
+    // algorithms of each instance, with a slack for the remaining
+    // assignments; other columns are added by pricing
+    static int selAlgTopK;
+
+    // if the greedy algorithm builds the tree level by level,
+    // expanding all nodes of one level concurrently
+    static bool greedyBreadthFirst;
+
+    // if >0, the greedy algorithm evaluates branches only
+    // at the borders of at most greedyBins bins per feature
+    static int greedyBins;
+
+    // if >0, the greedy algorithm keeps only this number of
+    // candidate algorithms per side when scanning a feature,
+    // the remaining ones are checked only when a lower bound
+    // on their cost does not prove them dominated
+    static int greedyCandAlgs;
+
+    // number of randomized greedy trees built, the cheapest
+    // greedy tree is the initial solution of the exact solvers
+    static int greedyPortfolio;
+
+    // with greedyPortfolio, number of the cheapest greedy trees
+    // loaded as starts of the MIP
+    static int greedyStarts;
+
+    // threads used in the greedy algorithm,
+    // 0 to use all available processors
+    static int threads;
 };
 
 #endif /* PARAMETERS_HPP_ */
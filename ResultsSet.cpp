@@ -35,6 +35,7 @@ ResultsSet::ResultsSet( const InstanceSet &_iset, const char *fileName, const en
     res_(nullptr),
     origRes_(nullptr),
     ranks_(nullptr),
+    evalRes_(nullptr),
     fmrs_(_fmrs),
     avInst(nullptr),
     stdDevInst_(nullptr),
@@ -246,8 +247,84 @@ ResultsSet::ResultsSet( const InstanceSet &_iset, const char *fileName, const en
     // storing original result before additional changes
     memcpy(origRes_[0], res_[0], sizeof(TResult)*(iset_.size()*algsettings_.size()));
 
-    // second pass, checking number of timeouts per instance
+    if (nMissing)
+    {
+        const double percm = ( (((double)nMissing))/(((double)iset_.size()*algsettings_.size())) )*100.0;
+        cout << "warning : there are " << nMissing << " results for instance x algorithm/parameter settings missing (" \
+             << setprecision(2) << percm \
+             << "%)" << endl;
+    }
+
+    double secs = ((double)(clock()-start)) / ((double)CLOCKS_PER_SEC);
+    cout << ir << " results loaded in " << setprecision(3) << secs << " seconds" << endl;
+
+    processResults();
+}
+
+ResultsSet::ResultsSet( const ResultsSet &other, const std::vector< int > &algs ) :
+    iset_(other.iset_),
+    res_(nullptr),
+    origRes_(nullptr),
+    ranks_(nullptr),
+    evalRes_(nullptr),
+    fmrs_(other.fmrs_),
+    avInst(nullptr),
+    stdDevInst_(nullptr),
+    worseInst(nullptr),
+    nTimeOutsInst(nullptr),
+    avRes_(nullptr),
+    rnkRes_(nullptr),
+    defRes_(nullptr)
+{
+    clock_t start = clock();
+
+    for ( const auto ia : algs )
+    {
+        assert( ia>=0 && ia<(int)other.algsettings_.size() );
+        algsByName_[other.algsettings_[ia]] = algsettings_.size();
+        algsettings_.push_back(other.algsettings_[ia]);
+    }
+
+    worseInst = new TResult[iset_.size()];
+
+    res_ = new TResult*[iset_.size()];
+    res_[0] = new TResult[iset_.size()*algsettings_.size()];
+    for ( int i=1 ; (i<iset_.size()) ; ++i )
+        res_[i] = res_[i-1] + algsettings_.size();
+    origRes_ = new TResult*[iset_.size()];
+    origRes_[0] = new TResult[iset_.size()*algsettings_.size()];
+    for ( int i=1 ; (i<iset_.size()) ; ++i )
+        origRes_[i] = origRes_[i-1] + algsettings_.size();
+    ranks_ = new int*[iset_.size()];
+    ranks_[0] = new int[iset_.size()*algsettings_.size()];
+    for ( int i=1 ; (i<iset_.size()) ; ++i )
+        ranks_[i] = ranks_[i-1] + algsettings_.size();
+
+    // worse result read of the selected algorithms,
+    // filled missing results may be larger
+    timeOut = std::numeric_limits<TResult>::min();
+    for ( int i=0 ; (i<iset_.size()) ; ++i )
+    {
+        for ( size_t j=0 ; (j<algsettings_.size()) ; ++j )
+        {
+            origRes_[i][j] = other.origRes_[i][algs[j]];
+            if (origRes_[i][j]<=other.timeOut)
+                timeOut = max( timeOut, origRes_[i][j] );
+        }
+    }
+    memcpy(res_[0], origRes_[0], sizeof(TResult)*(iset_.size()*algsettings_.size()));
+
+    double secs = ((double)(clock()-start)) / ((double)CLOCKS_PER_SEC);
+    cout << "results of " << algsettings_.size() << " algorithm settings projected in " << setprecision(3) << secs << " seconds" << endl;
+
+    processResults();
+}
+
+void ResultsSet::processResults()
+{
+    const auto worse = this->timeOut;
 
+    // second pass, checking number of timeouts per instance
     nTimeOutsInst = new int[iset_.size()];
     memset( nTimeOutsInst, 0, sizeof(int)*iset_.size());
 
@@ -310,17 +387,6 @@ ResultsSet::ResultsSet( const InstanceSet &_iset, const char *fileName, const en
         lowerBound += bestI;
     }
     
-    if (nMissing)
-    {
-        const double percm = ( (((double)nMissing))/(((double)iset_.size()*algsettings_.size())) )*100.0;
-        cout << "warning : there are " << nMissing << " results for instance x algorithm/parameter settings missing (" \
-             << setprecision(2) << percm \
-             << "%)" << endl;
-    }
-
-    double secs = ((double)(clock()-start)) / ((double)CLOCKS_PER_SEC);
-    cout << ir << " results loaded in " << setprecision(3) << secs << " seconds" << endl;
-
     clock_t startr = clock();
     cout << "Computing ranking and summarized results ... ";
 
@@ -328,6 +394,21 @@ ResultsSet::ResultsSet( const InstanceSet &_iset, const char *fileName, const en
 
     cout << "done in " << fixed << setprecision(2) <<
             (((double)clock()-startr) / ((double)CLOCKS_PER_SEC)) << endl;
+
+    switch (Parameters::eval)
+    {
+        case Average:
+            evalRes_ = res_;
+            break;
+        case Rank:
+            evalRes_ = new TResult*[iset_.size()];
+            evalRes_[0] = new TResult[iset_.size()*algsettings_.size()];
+            for ( int i=1 ; (i<iset_.size()) ; ++i )
+                evalRes_[i] = evalRes_[i-1] + algsettings_.size();
+            for ( size_t i=0 ; (i<iset_.size()*algsettings_.size()) ; ++i )
+                evalRes_[0][i] = (TResult)ranks_[0][i];
+            break;
+    }
     
     avInst = new TResult[iset_.size()];
     stdDevInst_ = new TResult[iset_.size()];
@@ -426,6 +507,11 @@ ResultsSet::~ResultsSet ()
     delete[] nLastRank;
     delete[] ranks_[0];
     delete[] ranks_;
+    if (evalRes_ != res_)
+    {
+        delete[] evalRes_[0];
+        delete[] evalRes_;
+    }
     delete[] res_[0];
     delete[] res_;
     delete[] origRes_[0];
@@ -630,6 +716,24 @@ void ResultsSet::saveFilteredDataSets(const char *featuresFile, const char *resu
 
 }
 
+void ResultsSet::saveFilteredResults( const char *fileName, int nAlgs, const int *algs ) const
+{
+    FILE *f = fopen(fileName, "w");
+    fprintf(f, "instance,algsetting,result\n");
+    for ( int ip=0 ; (ip<iset_.size()) ; ++ip )
+    {
+        if (this->stdDevInst_[ip]<=MIN_STD_DEV)
+            continue;
+
+        for ( int isa=0 ; (isa<nAlgs) ; ++isa )
+        {
+            const size_t ia = algs[isa];
+            fprintf(f, "%s,%s,%.4f\n", iset_.instance(ip).name(), algsettings_[ia].c_str(), this->res(ip, ia));
+        }
+    }
+    fclose(f);
+}
+
 double ResultsSet::origRes(size_t iIdx, size_t iAlg) const
 {
     return origRes_[iIdx][iAlg];
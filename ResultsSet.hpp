@@ -26,6 +26,11 @@ public:
                 const char *fileName,
                 const enum FMRStrategy _fmrs = WorseInstT2 );
 
+    // results of a subset of the algorithms of another results set
+    // (as selected by MIPSelAlg), for the same instances, without
+    // reading the results file again
+    ResultsSet( const ResultsSet &other, const std::vector< int > &algs );
+
     // returns a specific result
     TResult get(size_t iIdx, size_t aIdx) const;
 
@@ -42,6 +47,13 @@ public:
     // depending on param settings
     double res(size_t iIdx, size_t iAlg) const;
 
+    // results of all algorithms for instance iIdx, stored
+    // contiguously: normal result or rank depending on param
+    // settings, as in res()
+    const TResult *resInst(size_t iIdx) const {
+        return evalRes_[iIdx];
+    }
+
     // returns the original result per algorithm and instance
     double origRes(size_t iIdx, size_t iAlg) const;
 
@@ -75,6 +87,10 @@ public:
 
     void saveFilteredDataSets(const char *featuresFile, const char *resultsFile);
 
+    // saves, as res(), the results of the nAlgs algorithms in algs for
+    // the instances whose results are not all equal, as a results file
+    void saveFilteredResults( const char *fileName, int nAlgs, const int *algs ) const;
+
     const InstanceSet &instanceSet() const {
         return this->iset_;
     }
@@ -94,7 +110,14 @@ private:
     std::unordered_map< std::string, size_t > algsByName_;
     TResult **res_;
     TResult **origRes_;
+
+    // computes rankings and summaries from res_, with
+    // the results already read and missing ones filled
+    void processResults();
+
     int **ranks_;
+    // res_ or ranks, depending on the evaluation
+    TResult **evalRes_;
     const enum FMRStrategy fmrs_;
 
     TResult *avInst;
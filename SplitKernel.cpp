@@ -0,0 +1,210 @@
+/*
+ * SplitKernel.cpp
+ */
+
+#include "SplitKernel.hpp"
+
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SK_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static void sk_add_scalar( double *sum, const double *row, const size_t n )
+{
+    for ( size_t i=0 ; (i<n) ; ++i )
+        sum[i] += row[i];
+}
+
+static void sk_sub_scalar( double *sum, const double *row, const size_t n )
+{
+    for ( size_t i=0 ; (i<n) ; ++i )
+        sum[i] -= row[i];
+}
+
+static void sk_min_lr_scalar( const double *sumL, const double *tot, const size_t n,
+                              double *minL, double *minR )
+{
+    double mL = DBL_MAX, mR = DBL_MAX;
+    for ( size_t i=0 ; (i<n) ; ++i )
+    {
+        mL = min( mL, sumL[i] );
+        mR = min( mR, tot[i]-sumL[i] );
+    }
+    *minL = mL;
+    *minR = mR;
+}
+
+#ifdef SK_X86
+
+__attribute__((target("avx2")))
+static void sk_add_avx2( double *sum, const double *row, const size_t n )
+{
+    size_t i = 0;
+    for ( ; (i+4<=n) ; i+=4 )
+        _mm256_storeu_pd( sum+i, _mm256_add_pd( _mm256_loadu_pd(sum+i), _mm256_loadu_pd(row+i) ) );
+    for ( ; (i<n) ; ++i )
+        sum[i] += row[i];
+}
+
+__attribute__((target("avx2")))
+static void sk_sub_avx2( double *sum, const double *row, const size_t n )
+{
+    size_t i = 0;
+    for ( ; (i+4<=n) ; i+=4 )
+        _mm256_storeu_pd( sum+i, _mm256_sub_pd( _mm256_loadu_pd(sum+i), _mm256_loadu_pd(row+i) ) );
+    for ( ; (i<n) ; ++i )
+        sum[i] -= row[i];
+}
+
+__attribute__((target("avx2")))
+static void sk_min_lr_avx2( const double *sumL, const double *tot, const size_t n,
+                            double *minL, double *minR )
+{
+    __m256d vmL = _mm256_set1_pd( DBL_MAX );
+    __m256d vmR = _mm256_set1_pd( DBL_MAX );
+    size_t i = 0;
+    for ( ; (i+4<=n) ; i+=4 )
+    {
+        const __m256d l = _mm256_loadu_pd( sumL+i );
+        vmL = _mm256_min_pd( vmL, l );
+        vmR = _mm256_min_pd( vmR, _mm256_sub_pd( _mm256_loadu_pd(tot+i), l ) );
+    }
+
+    double bL[4], bR[4];
+    _mm256_storeu_pd( bL, vmL );
+    _mm256_storeu_pd( bR, vmR );
+    double mL = min( min(bL[0], bL[1]), min(bL[2], bL[3]) );
+    double mR = min( min(bR[0], bR[1]), min(bR[2], bR[3]) );
+    for ( ; (i<n) ; ++i )
+    {
+        mL = min( mL, sumL[i] );
+        mR = min( mR, tot[i]-sumL[i] );
+    }
+    *minL = mL;
+    *minR = mR;
+}
+
+__attribute__((target("avx512f")))
+static void sk_add_avx512( double *sum, const double *row, const size_t n )
+{
+    size_t i = 0;
+    for ( ; (i+8<=n) ; i+=8 )
+        _mm512_storeu_pd( sum+i, _mm512_add_pd( _mm512_loadu_pd(sum+i), _mm512_loadu_pd(row+i) ) );
+    for ( ; (i<n) ; ++i )
+        sum[i] += row[i];
+}
+
+__attribute__((target("avx512f")))
+static void sk_sub_avx512( double *sum, const double *row, const size_t n )
+{
+    size_t i = 0;
+    for ( ; (i+8<=n) ; i+=8 )
+        _mm512_storeu_pd( sum+i, _mm512_sub_pd( _mm512_loadu_pd(sum+i), _mm512_loadu_pd(row+i) ) );
+    for ( ; (i<n) ; ++i )
+        sum[i] -= row[i];
+}
+
+__attribute__((target("avx512f")))
+static void sk_min_lr_avx512( const double *sumL, const double *tot, const size_t n,
+                              double *minL, double *minR )
+{
+    // _mm512_min_pd merges into an undefined vector, which GCC reports
+    // as uninitialized: the masked version merging into the
+    // accumulator with all lanes set is used instead
+    const __mmask8 all = 0xFF;
+    __m512d vmL = _mm512_set1_pd( DBL_MAX );
+    __m512d vmR = _mm512_set1_pd( DBL_MAX );
+    size_t i = 0;
+    for ( ; (i+8<=n) ; i+=8 )
+    {
+        const __m512d l = _mm512_loadu_pd( sumL+i );
+        vmL = _mm512_mask_min_pd( vmL, all, vmL, l );
+        vmR = _mm512_mask_min_pd( vmR, all, vmR, _mm512_sub_pd( _mm512_loadu_pd(tot+i), l ) );
+    }
+
+    double bL[8], bR[8];
+    _mm512_storeu_pd( bL, vmL );
+    _mm512_storeu_pd( bR, vmR );
+    double mL = *min_element( bL, bL+8 );
+    double mR = *min_element( bR, bR+8 );
+    for ( ; (i<n) ; ++i )
+    {
+        mL = min( mL, sumL[i] );
+        mR = min( mR, tot[i]-sumL[i] );
+    }
+    *minL = mL;
+    *minR = mR;
+}
+
+#endif
+
+typedef void (*SKAddFn)( double *, const double *, const size_t );
+typedef void (*SKMinLRFn)( const double *, const double *, const size_t, double *, double * );
+
+struct SplitKernel
+{
+    SKAddFn add;
+    SKAddFn sub;
+    SKMinLRFn minLR;
+    const char *name;
+};
+
+// implementations supported by the CPU, fastest first
+static vector< SplitKernel > available_kernels()
+{
+    vector< SplitKernel > res;
+#ifdef SK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        res.push_back( SplitKernel{ sk_add_avx512, sk_sub_avx512, sk_min_lr_avx512, "avx512" } );
+    if (__builtin_cpu_supports("avx2"))
+        res.push_back( SplitKernel{ sk_add_avx2, sk_sub_avx2, sk_min_lr_avx2, "avx2" } );
+#endif
+    res.push_back( SplitKernel{ sk_add_scalar, sk_sub_scalar, sk_min_lr_scalar, "scalar" } );
+
+    return res;
+}
+
+static SplitKernel splitKernel = available_kernels()[0];
+
+void split_kernel_add( double *sum, const double *row, const size_t n )
+{
+    splitKernel.add( sum, row, n );
+}
+
+void split_kernel_sub( double *sum, const double *row, const size_t n )
+{
+    splitKernel.sub( sum, row, n );
+}
+
+void split_kernel_min_lr( const double *sumL, const double *tot, const size_t n,
+                          double *minL, double *minR )
+{
+    splitKernel.minLR( sumL, tot, n, minL, minR );
+}
+
+const char *split_kernel_name()
+{
+    return splitKernel.name;
+}
+
+bool split_kernel_select( const char *name )
+{
+    for ( const auto &sk : available_kernels() )
+    {
+        if (strcmp( sk.name, name )==0)
+        {
+            splitKernel = sk;
+            return true;
+        }
+    }
+
+    return false;
+}
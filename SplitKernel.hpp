@@ -0,0 +1,37 @@
+/*
+ * SplitKernel.hpp
+ */
+
+#ifndef SPLITKERNEL_HPP_
+#define SPLITKERNEL_HPP_
+
+#include <cstddef>
+
+// kernels used in the evaluation of splits: loops over all
+// algorithms with double accumulators. AVX-512 or AVX2
+// versions are selected at runtime, if supported by the CPU,
+// otherwise a scalar version is used. All versions operate
+// element by element in the same order, so results are
+// identical.
+
+// sum[i] += row[i]
+void split_kernel_add( double *sum, const double *row, const size_t n );
+
+// sum[i] -= row[i]
+void split_kernel_sub( double *sum, const double *row, const size_t n );
+
+// computes the smallest value in sumL and the smallest
+// value of (tot[i]-sumL[i]), i.e. the best algorithm in
+// the left and right sides of a split
+void split_kernel_min_lr( const double *sumL, const double *tot, const size_t n,
+                          double *minL, double *minR );
+
+// name of the implementation selected
+const char *split_kernel_name();
+
+// selects implementation name ("avx512", "avx2" or "scalar"),
+// returns false if it is not supported by the CPU. not thread
+// safe, used to check the vectorized versions
+bool split_kernel_select( const char *name );
+
+#endif /* SPLITKERNEL_HPP_ */
@@ -11,6 +11,7 @@
 #include <cfloat>
 #include <algorithm>
 #include <cstdlib>
+#include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -89,7 +90,10 @@ const char *Tree::node_label( const Node *node ) const
 
 void Tree::draw( const char *fileName ) const
 {
-    ofstream of(fileName);
+    // written to a temporary file which replaces fileName
+    // at the end, so that a complete file is always there
+    const string tmpName = string(fileName) + ".tmp";
+    ofstream of(tmpName.c_str());
     of << "digraph G {" << endl;
     of << " graph [fontname = \"helvetica\"];" << endl;
     of << " node [fontname = \"helvetica\"];" << endl;
@@ -155,6 +159,8 @@ void Tree::draw( const char *fileName ) const
     of << "}" << endl;
 
     of.close();
+    if (rename( tmpName.c_str(), fileName ))
+        cerr << "could not write " << fileName << endl;
 }
 
 Node *Tree::create_root()
@@ -225,7 +231,17 @@ void Tree::save( const char *fileName ) const
 
     root_->writeXML(&doc, tree);
 
-    doc.SaveFile(fileName);
+    const string tmpName = string(fileName) + ".tmp";
+    if (doc.SaveFile(tmpName.c_str())!=XML_SUCCESS || rename( tmpName.c_str(), fileName ))
+        cerr << "could not write " << fileName << endl;
+}
+
+void Tree::saveFiles() const
+{
+    if (Parameters::treeFile.size())
+        save(Parameters::treeFile.c_str());
+    if (Parameters::treeFileGV.size())
+        draw(Parameters::treeFileGV.c_str());
 }
 
 void Tree::addNode( Node *_node )
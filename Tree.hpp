@@ -31,13 +31,16 @@ public:
     // saves tree in XML
     void save( const char *fileName ) const;
 
+    // saves tree in treeFile and treeFileGV, if set
+    void saveFiles() const;
+
     // evaluate in a set of test instances
     double evaluate( const Dataset *testData ) const;
     
     // compute cost considering training data
     void computeCost();
     
-    double cost() {
+    double cost() const {
         return avCostLeafs;
     }
 
@@ -45,6 +48,10 @@ public:
         return root_;
     }
 
+    Node *root() {
+        return root_;
+    }
+
     virtual ~Tree ();
 private:
     char nLabel[8192];
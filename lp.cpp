@@ -108,6 +108,7 @@ using namespace std;
 #endif
 #ifdef CPX
 #include <cplex.h>
+#include <unistd.h>
 static CPXENVptr LPcpxDefaultEnv = NULL;
 #endif
 #ifdef GRB
@@ -165,6 +166,11 @@ struct _LinearProgram {
     int *msIdx;
     double *msVal;
     int msVars;
+    // additional starts of lp_add_mip_start, as column
+    // indexes and values, passed to CPLEX and cleared
+    // in the next optimization
+    vector< vector< int > > *_msAddIdx;
+    vector< vector< double > > *_msAddVal;
 
 
 
@@ -183,7 +189,11 @@ struct _LinearProgram {
     double relMIPGap;
     int parallel;
     int branchDir;
+    int seed;
+    int threads;
     char silent;
+    /* optimization stops once *terminate is nonzero */
+    volatile int *terminate;
 
     /* callback function */
     lp_cb callback_;
@@ -213,6 +223,10 @@ struct _LinearProgram {
 #endif
 #ifdef CPX
     CPXLPptr cpxLP;
+    /* environment of cpxLP, the default one or,
+     * when ownEnv, one created by lp_clone_own_env */
+    CPXENVptr cpxEnv;
+    char ownEnv;
 #endif // CPX
 #ifdef GRB
     GRBmodel* lp;
@@ -391,12 +405,10 @@ void lp_check_mipstart( LinearProgram *lp )
     // including only correct entries
     if ( p && p!=j )
     {
-        free( lp->msNames[0] );
-        free( lp->msNames );
-        lp->msNames = (char**) malloc( (p+1)*sizeof(char*) );
-        assert( lp->msNames );
-        lp->msNames[0] = (char*) malloc( totalChars*sizeof(char) );
-        assert( lp->msNames[0] );
+        delete[] lp->msNames[0];
+        delete[] lp->msNames;
+        lp->msNames = new char*[p+1];
+        lp->msNames[0] = new char[totalChars];
         for ( int i=0 ; (i<p) ; ++i )
         {
             char cName[512] = "";
@@ -467,17 +479,21 @@ LinearProgramPtr lp_create_from( LinearProgram *lp )
             abort();
         }
     }
+
+    /* clones stay in the environment of lp */
+    result->cpxEnv = lp ? lp->cpxEnv : LPcpxDefaultEnv;
+    result->ownEnv = 0;
     
     if ( lp && lp_cols(lp) )
     {
-        result->cpxLP = CPXcloneprob( LPcpxDefaultEnv, lp->cpxLP, &cpxError );
+        result->cpxLP = CPXcloneprob( result->cpxEnv, lp->cpxLP, &cpxError );
     }
     else
     {
-        result->cpxLP = CPXcreateprob(LPcpxDefaultEnv, &cpxError, "mip");
+        result->cpxLP = CPXcreateprob(result->cpxEnv, &cpxError, "mip");
     }
 
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    lp_check_for_cpx_error(result->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif // CPX
 #ifdef GRB
     if ( LPgrbDefaultEnv == NULL )
@@ -566,8 +582,8 @@ void lp_read(LinearProgram *lp, const char *fileName)
     assert(lp != NULL);
 
 #ifdef CPX
-    int cpxError = CPXreadcopyprob(LPcpxDefaultEnv, lp->cpxLP, fileName, NULL);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXreadcopyprob(lp->cpxEnv, lp->cpxLP, fileName, NULL);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     return;
 #endif
 #ifdef GRB
@@ -616,8 +632,8 @@ void lp_write_lp(LinearProgram *lp, const char *fileName)
     char format[64] = "LP";
     if (getFileType(fileName)=='M')
         strcpy( format, "MPS" );
-    cpxError = CPXwriteprob(LPcpxDefaultEnv, lp->cpxLP, fName, format);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    cpxError = CPXwriteprob(lp->cpxEnv, lp->cpxLP, fName, format);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
     return;
 #endif
@@ -690,7 +706,7 @@ void lp_set_direction(LinearProgram *lp, const char direction)
             lp->osiLP->setObjSense(1.0);
 #endif
 #ifdef CPX
-            CPXchgobjsen(LPcpxDefaultEnv, lp->cpxLP, CPX_MIN);
+            CPXchgobjsen(lp->cpxEnv, lp->cpxLP, CPX_MIN);
 #endif
 #ifdef GRB
             {
@@ -719,7 +735,7 @@ void lp_set_direction(LinearProgram *lp, const char direction)
             }
 #endif
 #ifdef CPX
-            CPXchgobjsen(LPcpxDefaultEnv, lp->cpxLP, CPX_MAX);
+            CPXchgobjsen(lp->cpxEnv, lp->cpxLP, CPX_MAX);
 #endif
             break;
         default:
@@ -760,7 +776,7 @@ int lp_get_direction(LinearProgram *lp)
     }
 #endif
 #ifdef CPX
-    switch (CPXgetobjsen(LPcpxDefaultEnv, lp->cpxLP)) {
+    switch (CPXgetobjsen(lp->cpxEnv, lp->cpxLP)) {
         case CPX_MIN:
             return LP_MIN;
             break;
@@ -885,8 +901,8 @@ void lp_add_row(LinearProgram *lp, const int nz,  int *indexes, double *coefs, c
 
     int matBeg[] = { 0, nz };
 
-    cpxError = CPXaddrows(LPcpxDefaultEnv, lp->cpxLP, 0, 1, nz, &rhs, &sense, matBeg, indexes, coefs, NULL, (char **) &name);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    cpxError = CPXaddrows(lp->cpxEnv, lp->cpxLP, 0, 1, nz, &rhs, &sense, matBeg, indexes, coefs, NULL, (char **) &name);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
     return;
 #endif // CPX
@@ -1059,8 +1075,8 @@ void lp_add_rows( LinearProgram *lp, int nRows, int *starts, int *idx, double *c
     for ( int i=0 ; i<nRows ; ++i )
         nz += starts[i+1]-starts[i];
      
-    int cpxError = CPXaddrows( LPcpxDefaultEnv, lp->cpxLP, 0, nRows, nz, rhs, sense, starts, idx, coef, NULL, (char **)names );
-    lp_check_for_cpx_error( LPcpxDefaultEnv, cpxError, __FILE__, __LINE__ );
+    int cpxError = CPXaddrows( lp->cpxEnv, lp->cpxLP, 0, nRows, nz, rhs, sense, starts, idx, coef, NULL, (char **)names );
+    lp_check_for_cpx_error( lp->cpxEnv, cpxError, __FILE__, __LINE__ );
 #endif
 #ifdef GLPK
     int r = lp_rows( lp );
@@ -1221,8 +1237,8 @@ void lp_add_cols(LinearProgram *lp, const int count, double *obj, double *lb, do
             }
     }
 
-    cpxError = CPXnewcols(LPcpxDefaultEnv, lp->cpxLP, count, obj, _lb, _ub, &type[0] , name);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    cpxError = CPXnewcols(lp->cpxEnv, lp->cpxLP, count, obj, _lb, _ub, &type[0] , name);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif // CPX
 #ifdef GLPK
     register int j, cols, currCol;
@@ -1370,8 +1386,8 @@ const double *lp_obj_coef( LinearProgram *lp )
 #ifdef CPX
     {
         lp->_obj->resize( lp_cols(lp) );
-        int cpxError =  CPXgetobj( LPcpxDefaultEnv, lp->cpxLP, &((*lp->_obj)[0]), 0, lp_cols(lp)-1 );
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        int cpxError =  CPXgetobj( lp->cpxEnv, lp->cpxLP, &((*lp->_obj)[0]), 0, lp_cols(lp)-1 );
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     }
     return &((*lp->_obj)[0]);
 #endif
@@ -1409,7 +1425,7 @@ int lp_cols(LinearProgram *lp)
     return numCols;
 #endif
 #ifdef CPX
-    return CPXgetnumcols(LPcpxDefaultEnv, lp->cpxLP);
+    return CPXgetnumcols(lp->cpxEnv, lp->cpxLP);
 #endif
 }
 
@@ -1433,7 +1449,7 @@ int lp_rows(LinearProgram *lp)
     return numRows;
 #endif
 #ifdef CPX
-    return CPXgetnumrows(LPcpxDefaultEnv, lp->cpxLP);
+    return CPXgetnumrows(lp->cpxEnv, lp->cpxLP);
 #endif
 }
 
@@ -1457,12 +1473,12 @@ char lp_is_integer(LinearProgram *lp, const int j)
     return lp->osiLP->isInteger(j);
 #endif
 #ifdef CPX
-    if (CPXgetprobtype(LPcpxDefaultEnv, lp->cpxLP) == CPXPROB_LP)
+    if (CPXgetprobtype(lp->cpxEnv, lp->cpxLP) == CPXPROB_LP)
         return 0;
 
     char colType[2];
-    int cpxError = CPXgetctype(LPcpxDefaultEnv, lp->cpxLP, colType, j, j);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXgetctype(lp->cpxEnv, lp->cpxLP, colType, j, j);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
     return ((colType[0] == CPX_BINARY) || (colType[0] == CPX_INTEGER));
 #endif
@@ -2001,22 +2017,22 @@ CBC_OPTIMIZATION_ERROR:
     lp_config_cpx_params(lp);
 
     if ((isMIP) && (!lp->optAsContinuous)) {
-        int cpxError = CPXmipopt(LPcpxDefaultEnv, lp->cpxLP);
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
-        int solStat = CPXgetstat(LPcpxDefaultEnv, lp->cpxLP);
+        int cpxError = CPXmipopt(lp->cpxEnv, lp->cpxLP);
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
+        int solStat = CPXgetstat(lp->cpxEnv, lp->cpxLP);
         bool hasSolution = false;
 
         lp->status = LP_NO_SOL_FOUND;
 
-        CPXsetdblparam( LPcpxDefaultEnv,  CPX_PARAM_EPAGAP, 1e-7 );
-        CPXsetdblparam( LPcpxDefaultEnv,  CPX_PARAM_EPGAP, 1e-5 );
+        CPXsetdblparam( lp->cpxEnv,  CPX_PARAM_EPAGAP, 1e-7 );
+        CPXsetdblparam( lp->cpxEnv,  CPX_PARAM_EPGAP, 1e-5 );
 
         switch (solStat) {
             case CPXMIP_OPTIMAL :
             case CPXMIP_OPTIMAL_TOL :
                 {
                     hasSolution = true;
-                    int status  = CPXgetobjval(LPcpxDefaultEnv, lp->cpxLP, &lp->obj);
+                    int status  = CPXgetobjval(lp->cpxEnv, lp->cpxLP, &lp->obj);
                     if (status) {
                         fprintf(stderr, "Could not get objval. At %s:%d.\n", __FILE__, __LINE__);
                         abort();
@@ -2037,7 +2053,7 @@ CBC_OPTIMIZATION_ERROR:
                 break;
             default: 
                 {
-                    int status  = CPXgetobjval(LPcpxDefaultEnv, lp->cpxLP, &lp->obj);
+                    int status  = CPXgetobjval(lp->cpxEnv, lp->cpxLP, &lp->obj);
                     if (status)
                         lp->status = LP_NO_SOL_FOUND;
                     else {
@@ -2051,76 +2067,76 @@ CBC_OPTIMIZATION_ERROR:
         if (hasSolution) {
             assert( ((int)lp->_x->size())>=lp_cols(lp) );
             // getting x
-            int cpxError = CPXgetx(LPcpxDefaultEnv, lp->cpxLP, &((*(lp->_x))[0]), 0, lp_cols(lp) - 1);
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            int cpxError = CPXgetx(lp->cpxEnv, lp->cpxLP, &((*(lp->_x))[0]), 0, lp_cols(lp) - 1);
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
             // getting slack
             double *slack = &((*lp->_slack)[0]);
-            cpxError = CPXgetslack(LPcpxDefaultEnv, lp->cpxLP, slack, 0, lp_rows(lp) - 1);
+            cpxError = CPXgetslack(lp->cpxEnv, lp->cpxLP, slack, 0, lp_rows(lp) - 1);
             for ( int i=0 ; (i<lp_rows(lp)) ; ++i )
                 slack[i] = fabs(slack[i]);
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
             /* getting solution pool */
-            int nsols = CPXgetsolnpoolnumsolns( LPcpxDefaultEnv, lp->cpxLP );
+            int nsols = CPXgetsolnpoolnumsolns( lp->cpxEnv, lp->cpxLP );
             if (nsols)
             {
                 lp->_savedSol->resize( nsols, vector< double >( lp_cols(lp), 0.0 )  );
                 lp->_savedObj->resize( nsols, DBL_MAX );
                 for ( int i=0 ; (i<nsols) ; ++i )
                 {
-                    int error = CPXgetsolnpoolobjval( LPcpxDefaultEnv, lp->cpxLP, i, &((*(lp->_savedObj))[i]) );
+                    int error = CPXgetsolnpoolobjval( lp->cpxEnv, lp->cpxLP, i, &((*(lp->_savedObj))[i]) );
                     assert( !error );
-                    cpxError = CPXgetsolnpoolx( LPcpxDefaultEnv, lp->cpxLP, i,  &((*(lp->_savedSol))[i][0]), 0, lp_cols(lp)-1 );
-                    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+                    cpxError = CPXgetsolnpoolx( lp->cpxEnv, lp->cpxLP, i,  &((*(lp->_savedSol))[i][0]), 0, lp_cols(lp)-1 );
+                    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
                 }
             }
         }
 
         if ( ( lp->status != LP_INFEASIBLE && lp->status != LP_UNBOUNDED ) )
         {
-            int cpxError = CPXgetbestobjval( LPcpxDefaultEnv, lp->cpxLP, &lp->bestBound );
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            int cpxError = CPXgetbestobjval( lp->cpxEnv, lp->cpxLP, &lp->bestBound );
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
         }
 
         goto OPTIMIZATION_CONCLUDED;
     }
     else {
         int status = 0;
-        if (CPXgetprobtype(LPcpxDefaultEnv, lp->cpxLP) == CPXPROB_MILP) {
+        if (CPXgetprobtype(lp->cpxEnv, lp->cpxLP) == CPXPROB_MILP) {
             /* backing up column types */
             ctypes.resize( lp_cols(lp), CPX_CONTINUOUS );
-            int cpxError = CPXgetctype( LPcpxDefaultEnv, lp->cpxLP, &ctypes[0], 0, lp_cols(lp)-1 );
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            int cpxError = CPXgetctype( lp->cpxEnv, lp->cpxLP, &ctypes[0], 0, lp_cols(lp)-1 );
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
             /* changing problem type */
-            cpxError = CPXchgprobtype(LPcpxDefaultEnv, lp->cpxLP, CPXPROB_LP);
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            cpxError = CPXchgprobtype(lp->cpxEnv, lp->cpxLP, CPXPROB_LP);
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
             restoreColumnTypes = true;
         }
-        int cpxError = CPXlpopt(LPcpxDefaultEnv, lp->cpxLP );
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
-        int solStat = CPXgetstat(LPcpxDefaultEnv, lp->cpxLP);
+        int cpxError = CPXlpopt(lp->cpxEnv, lp->cpxLP );
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
+        int solStat = CPXgetstat(lp->cpxEnv, lp->cpxLP);
 
         switch (solStat) {
             case CPX_STAT_OPTIMAL : 
                 {
-                    status = CPXgetobjval(LPcpxDefaultEnv, lp->cpxLP, &lp->obj);
+                    status = CPXgetobjval(lp->cpxEnv, lp->cpxLP, &lp->obj);
                     if (status) {
                         sprintf(errorMsg, "Could not get objval.");
                         errorLine = __LINE__;
                         goto OPTIMIZATION_ERROR;
                     }
 
-                    int cpxError = CPXgetx(LPcpxDefaultEnv, lp->cpxLP, &((*(lp->_x))[0]), 0, lp_cols(lp) - 1);
-                    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+                    int cpxError = CPXgetx(lp->cpxEnv, lp->cpxLP, &((*(lp->_x))[0]), 0, lp_cols(lp) - 1);
+                    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
-                    cpxError = CPXgetdj(LPcpxDefaultEnv, lp->cpxLP, &((*(lp->_rc))[0]), 0, lp_cols(lp) - 1);
-                    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+                    cpxError = CPXgetdj(lp->cpxEnv, lp->cpxLP, &((*(lp->_rc))[0]), 0, lp_cols(lp) - 1);
+                    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
-                    cpxError = CPXgetpi(LPcpxDefaultEnv, lp->cpxLP, &((*(lp->_pi))[0]), 0, lp_rows(lp) - 1);
-                    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+                    cpxError = CPXgetpi(lp->cpxEnv, lp->cpxLP, &((*(lp->_pi))[0]), 0, lp_rows(lp) - 1);
+                    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
-                    cpxError = CPXgetslack(LPcpxDefaultEnv, lp->cpxLP, &((*(lp->_slack))[0]), 0, lp_rows(lp) - 1);
-                    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+                    cpxError = CPXgetslack(lp->cpxEnv, lp->cpxLP, &((*(lp->_slack))[0]), 0, lp_rows(lp) - 1);
+                    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
                     lp->status = LP_OPTIMAL;
                     goto OPTIMIZATION_CONCLUDED;
@@ -2140,7 +2156,7 @@ CBC_OPTIMIZATION_ERROR:
                 break;
             default :
                 char statStr[256];
-                CPXgetstatstring(LPcpxDefaultEnv, solStat, statStr);
+                CPXgetstatstring(lp->cpxEnv, solStat, statStr);
                 sprintf(errorMsg, "CPLEX CPXlpopt returned unhandled optimization status %s.\n", statStr);
                 errorLine = __LINE__;
                 goto OPTIMIZATION_ERROR;
@@ -2356,8 +2372,8 @@ OPTIMIZATION_CONCLUDED:
     {
         vector< int > idx( lp_cols(lp), 0 );
         for ( int i=0 ; (i<lp_cols(lp)) ; i++ ) idx[i] = i;
-        int cpxError = CPXchgctype( LPcpxDefaultEnv, lp->cpxLP, lp_cols(lp), &idx[0], &(ctypes[0]) );
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        int cpxError = CPXchgctype( lp->cpxEnv, lp->cpxLP, lp_cols(lp), &idx[0], &(ctypes[0]) );
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     }
 #endif
 #ifdef GRB
@@ -2699,7 +2715,9 @@ void lp_free(LinearProgramPtr *lp)
 #ifdef CPX
     //CPXfree((*lp)->cpxLP);//LPcpxDefaultEnv);
     //CPXfreeparenv(LPcpxDefaultEnv,  &LPcpxDefaultEnv );
-    CPXfreeprob(LPcpxDefaultEnv, &((*lp)->cpxLP));
+    CPXfreeprob((*lp)->cpxEnv, &((*lp)->cpxLP));
+    if ((*lp)->ownEnv)
+        CPXcloseCPLEX( &((*lp)->cpxEnv) );
 #endif // CPX
 #ifdef GRB
     int grbError = GRBfreemodel( ((*lp)->lp) );
@@ -2731,7 +2749,8 @@ void lp_free(LinearProgramPtr *lp)
         delete[] (*lp)->msIdx;
     if ((*lp)->msVal)
         delete[] (*lp)->msVal;
-
+    delete (*lp)->_msAddIdx;
+    delete (*lp)->_msAddVal;
 
     free(*lp);
     *lp = NULL;
@@ -2746,9 +2765,9 @@ int lp_col( LinearProgram *lp, int col, int *idx, double *coef )
 #ifdef CPX
     int surplus = -INT_MAX;
     int rmatbeg[] = { 0, lp_rows(lp) };
-    int cpxError = CPXgetcols(LPcpxDefaultEnv, lp->cpxLP, &result, &rmatbeg[0], idx, coef, lp_rows(lp), &surplus, col, col );
+    int cpxError = CPXgetcols(lp->cpxEnv, lp->cpxLP, &result, &rmatbeg[0], idx, coef, lp_rows(lp), &surplus, col, col );
     assert( surplus>=0 );
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef GLPK
     result = glp_get_mat_col(lp->_lp, col + 1, idx - 1, coef - 1);
@@ -2801,9 +2820,9 @@ int lp_row(LinearProgram *lp, int row, int *idx, double *coef)
 #ifdef CPX
     int surplus= -INT_MAX;
     int rmatbeg[2] = { -INT_MAX, -INT_MAX };
-    int cpxError = CPXgetrows(LPcpxDefaultEnv, lp->cpxLP, &result, &rmatbeg[0], idx, coef, lp_cols(lp) + 1, &surplus, row, row);
+    int cpxError = CPXgetrows(lp->cpxEnv, lp->cpxLP, &result, &rmatbeg[0], idx, coef, lp_cols(lp) + 1, &surplus, row, row);
     assert( surplus>=0 );
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 
 #ifdef CBC
@@ -2847,8 +2866,8 @@ double lp_rhs(LinearProgram *lp, int row)
 #endif
 #ifdef CPX
     double rhs;
-    int cpxError = CPXgetrhs(LPcpxDefaultEnv, lp->cpxLP, &rhs, row, row);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXgetrhs(lp->cpxEnv, lp->cpxLP, &rhs, row, row);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     return rhs;
 #endif
 #ifdef CBC
@@ -2902,8 +2921,8 @@ char lp_sense(LinearProgram *lp, int row)
 #ifdef CPX
     int cpxError;
     char result;
-    cpxError = CPXgetsense(LPcpxDefaultEnv, lp->cpxLP, &result, row, row);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    cpxError = CPXgetsense(lp->cpxEnv, lp->cpxLP, &result, row, row);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     return result;
 #endif
 #ifdef CBC
@@ -2944,8 +2963,8 @@ char *lp_row_name(LinearProgram *lp, int row, char *dest)
 #endif
 #ifdef CPX
     int surplus = 0;
-    int cpxError = CPXgetrowname(LPcpxDefaultEnv, lp->cpxLP, &dest, dest, 256, &surplus, row, row);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXgetrowname(lp->cpxEnv, lp->cpxLP, &dest, dest, 256, &surplus, row, row);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef CBC
     strcpy(dest, lp->osiLP->getRowName(row).c_str());
@@ -2977,8 +2996,8 @@ char *lp_col_name(LinearProgram *lp, int col, char *dest)
 #endif
 #ifdef CPX
     int surplus = 0;
-    int cpxError = CPXgetcolname(LPcpxDefaultEnv, lp->cpxLP, &dest, dest, 256, &surplus, col, col);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXgetcolname(lp->cpxEnv, lp->cpxLP, &dest, dest, 256, &surplus, col, col);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef CBC
     strcpy(dest, lp->osiLP->getColName(col).c_str());
@@ -3008,8 +3027,8 @@ double lp_col_lb(LinearProgram *lp, int col)
     double lb;
     int begin = col;
     int end = col;
-    int cpxError = CPXgetlb(LPcpxDefaultEnv, lp->cpxLP, &lb, begin, end);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXgetlb(lp->cpxEnv, lp->cpxLP, &lb, begin, end);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
     return lb;
 #endif
@@ -3040,8 +3059,8 @@ double lp_col_ub(LinearProgram *lp, int col)
     double ub;
     int begin = col;
     int end = col;
-    int cpxError = CPXgetub(LPcpxDefaultEnv, lp->cpxLP, &ub, begin, end);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXgetub(lp->cpxEnv, lp->cpxLP, &ub, begin, end);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     return ub;
 #endif
 #ifdef CBC
@@ -3069,8 +3088,8 @@ void lp_set_obj(LinearProgram *lp, double *obj)
     for (int i = 0 ; (i < lp_cols(lp)) ; i++)
         idx[i] = i;
 
-    int cpxError = CPXchgobj(LPcpxDefaultEnv, lp->cpxLP, lp_cols(lp), &idx[0], obj);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXchgobj(lp->cpxEnv, lp->cpxLP, lp_cols(lp), &idx[0], obj);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef CBC
     return lp->osiLP->setObjective(obj);
@@ -3114,14 +3133,14 @@ void lp_add_col(LinearProgram *lp, double obj, double lb, double ub, char intege
     }
 
     int matBeg[] = { 0, nz };
-    int cpxError = CPXaddcols( LPcpxDefaultEnv, lp->cpxLP, 1, nz, &obj, matBeg, rowIdx, rowCoef, &lb, &ub, &name );
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXaddcols( lp->cpxEnv, lp->cpxLP, 1, nz, &obj, matBeg, rowIdx, rowCoef, &lb, &ub, &name );
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
     if ( type != CPX_CONTINUOUS )
     {
         int idx = lp_cols(lp)-1;
-        cpxError = CPXchgctype( LPcpxDefaultEnv, lp->cpxLP, 1, &idx, &type  );
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        cpxError = CPXchgctype( lp->cpxEnv, lp->cpxLP, 1, &idx, &type  );
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     }
 
     return;
@@ -3194,8 +3213,8 @@ void lp_set_rhs(LinearProgram *lp, int row, double rhs)
 #endif
 
 #ifdef CPX
-    int cpxError = CPXchgrhs(LPcpxDefaultEnv, lp->cpxLP, 1, &row, &rhs);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXchgrhs(lp->cpxEnv, lp->cpxLP, 1, &row, &rhs);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #else
 
 
@@ -3250,7 +3269,7 @@ void lp_check_for_cpx_error(CPXENVptr env, int errorCode, const char *sourceFile
 {
     if (errorCode) {
         char errorStr[256];
-        CPXgeterrorstring(LPcpxDefaultEnv, errorCode, errorStr);
+        CPXgeterrorstring(env, errorCode, errorStr);
         fprintf(stderr, "CPLEX Error: %s\n", errorStr);
         fprintf(stderr, "Inside LP Library - %s:%d\n\n", sourceFile, sourceLine);
         abort();
@@ -3319,6 +3338,24 @@ void lp_set_parallel(LinearProgram *lp, char onOff)
     lp->parallel = onOff;
 }
 
+void lp_set_seed(LinearProgram *lp, int seed)
+{
+    assert(lp != NULL);
+    lp->seed = seed;
+}
+
+void lp_set_threads(LinearProgram *lp, int threads)
+{
+    assert(lp != NULL);
+    lp->threads = threads;
+}
+
+void lp_set_terminate(LinearProgram *lp, volatile int *terminate)
+{
+    assert(lp != NULL);
+    lp->terminate = terminate;
+}
+
 void lp_set_heur_proximity(LinearProgram *lp, char onOff)
 {
     assert(lp != NULL);
@@ -3526,21 +3563,21 @@ void lp_set_col_bounds(LinearProgram *lp, int col, const double lb, const double
     const int idx[] = { col };
     if ( fabs(l-u)<= EPS )
     {
-        int cpxError = CPXchgbds( LPcpxDefaultEnv, lp->cpxLP, 1, idx, "B", &lb ) ;
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        int cpxError = CPXchgbds( lp->cpxEnv, lp->cpxLP, 1, idx, "B", &lb ) ;
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     }
     else
     {
         if ( (l!=-DBL_MAX) && (l!=DBL_MIN) )
         {
             int cpxError;
-            cpxError = CPXchgbds( LPcpxDefaultEnv, lp->cpxLP, 1, idx, "L", &lb ) ;
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            cpxError = CPXchgbds( lp->cpxEnv, lp->cpxLP, 1, idx, "L", &lb ) ;
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
         }
         if ( u!=DBL_MAX )
         {
-            int cpxError = CPXchgbds( LPcpxDefaultEnv, lp->cpxLP, 1, idx, "U", &ub ) ;
-            lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+            int cpxError = CPXchgbds( lp->cpxEnv, lp->cpxLP, 1, idx, "U", &ub ) ;
+            lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
         }
     }
 #endif
@@ -3602,6 +3639,9 @@ LinearProgram *lp_clone(LinearProgram *lp)
     result->maxSeconds = lp->maxSeconds;
     result->maxSavedSols = lp->maxSavedSols;
     result->branchDir = lp->branchDir;
+    result->seed = lp->seed;
+    result->threads = lp->threads;
+    result->terminate = lp->terminate;
     result->silent = lp->silent;
 
     (*result->_x)         = (*lp->_x);
@@ -3616,6 +3656,7 @@ LinearProgram *lp_clone(LinearProgram *lp)
     (*result->rowNameIdx) = (*lp->rowNameIdx);
 #endif
     (*result->_orig)      = (*lp->_orig);
+    (*result->_priorities) = (*lp->_priorities);
  
     strcpy(result->solOutFN, lp->solOutFN );
     strcpy(result->solInFN, lp->solInFN );
@@ -3656,6 +3697,9 @@ LinearProgram *lp_clone(LinearProgram *lp)
         }
     }
 
+    (*result->_msAddIdx) = (*lp->_msAddIdx);
+    (*result->_msAddVal) = (*lp->_msAddVal);
+
 #ifdef GRB
     result->nModelChanges = lp->nModelChanges;
 #endif
@@ -3663,6 +3707,45 @@ LinearProgram *lp_clone(LinearProgram *lp)
     return result;
 }
 
+LinearProgram *lp_clone_own_env(LinearProgram *lp)
+{
+    assert(lp != NULL);
+
+    LinearProgram *result = lp_clone( lp );
+#ifdef CPX
+    /* problems are not copied across environments: the problem
+     * is saved and read again in the new environment */
+    char fileName[] = "/tmp/lpenvXXXXXX";
+    int fd = mkstemp( fileName );
+    if (fd == -1) {
+        fprintf(stderr, "Error creating temporary file for a new CPLEX environment. Quiting.\n");
+        abort();
+    }
+    close( fd );
+
+    int cpxError = CPXwriteprob( lp->cpxEnv, lp->cpxLP, fileName, "SAV" );
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
+
+    CPXENVptr env = CPXopenCPLEX( &cpxError );
+    if (!env) {
+        fprintf(stderr, "Error opening CPLEX environment. Quiting.\n");
+        abort();
+    }
+
+    CPXfreeprob( result->cpxEnv, &(result->cpxLP) );
+    result->cpxEnv = env;
+    result->ownEnv = 1;
+    result->cpxLP = CPXcreateprob( env, &cpxError, "mip" );
+    lp_check_for_cpx_error(env, cpxError, __FILE__, __LINE__);
+    cpxError = CPXreadcopyprob( env, result->cpxLP, fileName, "SAV" );
+    lp_check_for_cpx_error(env, cpxError, __FILE__, __LINE__);
+
+    remove( fileName );
+#endif // CPX
+
+    return result;
+}
+
 void lp_fix_col(LinearProgram *lp, int col, double val)
 {
     LP_CHECK_COL_INDEX(lp, col);
@@ -3681,8 +3764,8 @@ void lp_fix_col(LinearProgram *lp, int col, double val)
 #endif
 #ifdef CPX
     char lu = 'B';
-    int cpxError = CPXchgbds(LPcpxDefaultEnv , lp->cpxLP, 1, &col, &lu, &val);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXchgbds(lp->cpxEnv , lp->cpxLP, 1, &col, &lu, &val);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef GLPK
     glp_set_col_bnds(lp->_lp, col+1, GLP_FX, val, val);
@@ -3741,11 +3824,16 @@ void lp_initialize(LinearProgram *lp)
     lp->cutoff = DBL_MAX;
     lp->cutoffAsConstraint = 0;
     lp->branchDir = INT_NOT_SET;
+    lp->seed = INT_NOT_SET;
+    lp->threads = INT_NOT_SET;
+    lp->terminate = NULL;
 
     lp->msNames = NULL;
     lp->msIdx = NULL;
     lp->msVal = NULL;
     lp->msVars = 0;
+    lp->_msAddIdx = new vector< vector< int > >();
+    lp->_msAddVal = new vector< vector< double > >();
 
 #ifdef CBC
     lp->cutPool = NULL;
@@ -3807,7 +3895,7 @@ int lp_col_index(LinearProgram *lp, const char *name)
 #endif
 #ifdef CPX
     int index = -1;
-    int cpxError = CPXgetcolindex( LPcpxDefaultEnv, lp->cpxLP, name, &index );
+    int cpxError = CPXgetcolindex( lp->cpxEnv, lp->cpxLP, name, &index );
     if (cpxError)
         return -1;
 
@@ -3840,7 +3928,7 @@ int lp_row_index(LinearProgram *lp, const char *name)
 #endif
 #ifdef CPX
     int index = -1;
-    int cpxError = CPXgetrowindex( LPcpxDefaultEnv, lp->cpxLP, name, &index );
+    int cpxError = CPXgetrowindex( lp->cpxEnv, lp->cpxLP, name, &index );
     if (cpxError)
         return -1;
 
@@ -3909,6 +3997,12 @@ void lp_config_grb_params(LinearProgram *lp)
     if ( lp->maxSeconds != INT_NOT_SET )
         GRBsetdblparam( env, GRB_DBL_PAR_TIMELIMIT, lp->maxSeconds);
 
+    if ( lp->seed != INT_NOT_SET )
+        GRBsetintparam( env, GRB_INT_PAR_SEED, lp->seed );
+
+    if ( lp->threads != INT_NOT_SET )
+        GRBsetintparam( env, GRB_INT_PAR_THREADS, lp->threads );
+
     if ( lp->cutoff )
         GRBsetdblparam( env, GRB_DBL_PAR_CUTOFF, lp->cutoff );
 
@@ -3997,15 +4091,21 @@ void lp_unset_grb_params( LinearProgram *lp )
 void lp_config_cpx_params(LinearProgram *lp)
 {
     if (lp->maxSeconds != INT_NOT_SET)
-        CPXsetdblparam(LPcpxDefaultEnv, CPX_PARAM_TILIM, lp->maxSeconds);
+        CPXsetdblparam(lp->cpxEnv, CPX_PARAM_TILIM, lp->maxSeconds);
     if (lp->maxSolutions == 1)
-        CPXsetdblparam(LPcpxDefaultEnv, CPX_PARAM_EPGAP, 1.0);
+        CPXsetdblparam(lp->cpxEnv, CPX_PARAM_EPGAP, 1.0);
     if (lp->maxNodes != INT_NOT_SET)
-        CPXsetintparam(LPcpxDefaultEnv, CPX_PARAM_NODELIM, lp->maxNodes);
+        CPXsetintparam(lp->cpxEnv, CPX_PARAM_NODELIM, lp->maxNodes);
     if ((lp->silent) || (!lp->printMessages))
-        CPXsetintparam(LPcpxDefaultEnv, CPX_PARAM_SCRIND, CPX_OFF);
+        CPXsetintparam(lp->cpxEnv, CPX_PARAM_SCRIND, CPX_OFF);
     else
-        CPXsetintparam(LPcpxDefaultEnv, CPX_PARAM_SCRIND, CPX_ON);
+        CPXsetintparam(lp->cpxEnv, CPX_PARAM_SCRIND, CPX_ON);
+    if (lp->seed != INT_NOT_SET)
+        CPXsetintparam(lp->cpxEnv, CPX_PARAM_RANDOMSEED, lp->seed);
+    if (lp->threads != INT_NOT_SET)
+        CPXsetintparam(lp->cpxEnv, CPX_PARAM_THREADS, lp->threads);
+    /* also clears a flag of a previous optimization */
+    CPXsetterminate(lp->cpxEnv, lp->terminate);
 
     if (lp->_priorities->size()>0)
     {
@@ -4014,8 +4114,8 @@ void lp_config_cpx_params(LinearProgram *lp)
             idx[i] = i;
         vector< int > direction( lp_cols(lp), CPX_BRANCH_GLOBAL);
 
-        int cpxError = CPXcopyorder( LPcpxDefaultEnv, lp->cpxLP, lp_cols(lp), &idx[0], &((*lp->_priorities)[0]), &direction[0] );
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        int cpxError = CPXcopyorder( lp->cpxEnv, lp->cpxLP, lp_cols(lp), &idx[0], &((*lp->_priorities)[0]), &direction[0] );
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     }
 
     if ( lp->mipEmphasis != LP_ME_DEFAULT )
@@ -4024,13 +4124,13 @@ void lp_config_cpx_params(LinearProgram *lp)
         {
             case LP_ME_OPTIMALITY:
                 {
-                    CPXsetintparam(LPcpxDefaultEnv, CPX_PARAM_MIPEMPHASIS, CPX_MIPEMPHASIS_BESTBOUND );
+                    CPXsetintparam(lp->cpxEnv, CPX_PARAM_MIPEMPHASIS, CPX_MIPEMPHASIS_BESTBOUND );
                     break;
                 }
             case LP_ME_FEASIBILITY:
                 {
-                    CPXsetintparam(LPcpxDefaultEnv, CPX_PARAM_MIPEMPHASIS, CPX_MIPEMPHASIS_HIDDENFEAS );
-                    //CPXsetintparam(LPcpxDefaultEnv, CPX_PARAM_POLISHAFTERINTSOL, 1 );
+                    CPXsetintparam(lp->cpxEnv, CPX_PARAM_MIPEMPHASIS, CPX_MIPEMPHASIS_HIDDENFEAS );
+                    //CPXsetintparam(lp->cpxEnv, CPX_PARAM_POLISHAFTERINTSOL, 1 );
                     break;
                 }
         }
@@ -4038,20 +4138,20 @@ void lp_config_cpx_params(LinearProgram *lp)
     }
 
     if (lp->cutoff!=DBL_MAX)
-        CPXsetdblparam( LPcpxDefaultEnv, CPXPARAM_MIP_Tolerances_UpperCutoff, lp->cutoff );
+        CPXsetdblparam( lp->cpxEnv, CPXPARAM_MIP_Tolerances_UpperCutoff, lp->cutoff );
 
     if ( lp->absMIPGap != DBL_MAX )
     {
-        double agap;  CPXgetdblparam( LPcpxDefaultEnv, CPXPARAM_MIP_Tolerances_AbsMIPGap, &agap );
+        double agap;  CPXgetdblparam( lp->cpxEnv, CPXPARAM_MIP_Tolerances_AbsMIPGap, &agap );
         printf("changing absolute MIP GAP from %g to %g\n", agap, lp->absMIPGap );
-        CPXsetdblparam( LPcpxDefaultEnv, CPXPARAM_MIP_Tolerances_AbsMIPGap, lp->absMIPGap );
+        CPXsetdblparam( lp->cpxEnv, CPXPARAM_MIP_Tolerances_AbsMIPGap, lp->absMIPGap );
     }
 
     if ( lp->relMIPGap != DBL_MAX )
     {
-        double rgap;  CPXgetdblparam( LPcpxDefaultEnv, CPXPARAM_MIP_Tolerances_MIPGap, &rgap );
+        double rgap;  CPXgetdblparam( lp->cpxEnv, CPXPARAM_MIP_Tolerances_MIPGap, &rgap );
         printf("changing relative MIP GAP from %g to %g\n", rgap, lp->relMIPGap );
-        CPXsetdblparam( LPcpxDefaultEnv, CPXPARAM_MIP_Tolerances_MIPGap, lp->relMIPGap );
+        CPXsetdblparam( lp->cpxEnv, CPXPARAM_MIP_Tolerances_MIPGap, lp->relMIPGap );
     }
 
     if ( lp->msVars )
@@ -4067,37 +4167,51 @@ void lp_config_cpx_params(LinearProgram *lp)
 
         const int nNz = lp->msVars;
 
-        int cpxError = CPXaddmipstarts( LPcpxDefaultEnv, lp->cpxLP, 1, nNz, beg, idx, coef,
+        int cpxError = CPXaddmipstarts( lp->cpxEnv, lp->cpxLP, 1, nNz, beg, idx, coef,
                 effort, NULL );
-        lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     }
-}
-#endif // CPX
 
+    if ( lp->_msAddIdx->size() )
+    {
+        // additional starts, kept by CPLEX in the problem
+        // after added, so that they are added only once
+        const int nStarts = (int)lp->_msAddIdx->size();
+        vector< int > beg( nStarts );
+        vector< int > idx;
+        vector< double > coef;
+        for ( int i=0 ; (i<nStarts) ; ++i )
+        {
+            beg[i] = (int)idx.size();
+            idx.insert( idx.end(), (*lp->_msAddIdx)[i].begin(), (*lp->_msAddIdx)[i].end() );
+            coef.insert( coef.end(), (*lp->_msAddVal)[i].begin(), (*lp->_msAddVal)[i].end() );
+        }
+        vector< int > effort( nStarts, CPX_MIPSTART_SOLVEMIP );
 
-void lp_write_sol(LinearProgram *lp, const char *fileName)
-{
-    assert( lp != NULL );
-    assert( lp_cols(lp)>0 );
+        int cpxError = CPXaddmipstarts( lp->cpxEnv, lp->cpxLP, nStarts, (int)idx.size(), &beg[0],
+                idx.size() ? &idx[0] : NULL, coef.size() ? &coef[0] : NULL, &effort[0], NULL );
+        lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 
-    if ( lp_obj_value(lp) == DBL_MAX ) {
-        fprintf(stderr, "No solution to write.\n");
-        abort();
+        lp->_msAddIdx->clear();
+        lp->_msAddVal->clear();
     }
+}
+#endif // CPX
 
+
+/* writes x, of objective value obj, in fileName: one line per nonzero with
+ * column index, name, value and objective coefficient after header */
+static void lp_write_sol_vals( LinearProgram *lp, const char *fileName, const char *header, double objValue, const double *x )
+{
     FILE *fsol = fopen(fileName, "w");
     if (fsol == NULL) {
         fprintf(stderr, "Could not open file %s.\n", fileName);
         abort();
     }
 
-    if (lp->status == LP_OPTIMAL)
-        fprintf(fsol, "Optimal (within gap tolerance) - objective value %g - solution time %g\n", lp_obj_value(lp), lp->solutionTime );
-    else
-        fprintf(fsol, "Stopped on iterations - objective value %g - solution time %g\n", lp_obj_value(lp), lp->solutionTime );
+    fprintf(fsol, "%s - objective value %g - solution time %g\n", header, objValue, lp->solutionTime );
 
     const int nCols = lp_cols(lp);
-    const double *x = lp_x(lp);
     const double *obj = lp_obj_coef( lp );
     char cName[256];
     for (int i = 0 ; (i < nCols) ; ++i) {
@@ -4114,6 +4228,40 @@ void lp_write_sol(LinearProgram *lp, const char *fileName)
     fclose(fsol);
 }
 
+void lp_write_sol(LinearProgram *lp, const char *fileName)
+{
+    assert( lp != NULL );
+    assert( lp_cols(lp)>0 );
+
+    if ( lp_obj_value(lp) == DBL_MAX ) {
+        fprintf(stderr, "No solution to write.\n");
+        abort();
+    }
+
+    lp_write_sol_vals( lp, fileName, (lp->status == LP_OPTIMAL) ? "Optimal (within gap tolerance)" :
+            "Stopped on iterations", lp_obj_value(lp), lp_x(lp) );
+}
+
+void lp_write_sol_atomic(LinearProgram *lp, const char *fileName)
+{
+    const string tmpName = string(fileName) + ".tmp";
+
+    lp_write_sol(lp, tmpName.c_str());
+    if (rename(tmpName.c_str(), fileName))
+        fprintf(stderr, "Could not write %s.\n", fileName);
+}
+
+void lp_write_x_atomic( LinearProgram *lp, const char *fileName, const double *x, double objValue )
+{
+    assert( lp != NULL && x != NULL );
+
+    const string tmpName = string(fileName) + ".tmp";
+
+    lp_write_sol_vals( lp, tmpName.c_str(), "Feasible solution", objValue, x );
+    if (rename(tmpName.c_str(), fileName))
+        fprintf(stderr, "Could not write %s.\n", fileName);
+}
+
 void lp_parse_options(LinearProgram *lp, int argc, const char **argv)
 {
     for (int i = 0 ; (i < argc) ; ++i) {
@@ -4268,6 +4416,7 @@ void lp_load_mip_starti( LinearProgram *lp, int count, const int *colIndexes, co
     }
     if (lp->msIdx)
         delete[] lp->msIdx;
+    lp->msIdx = NULL;
     if (lp->msVal)
         delete[] lp->msVal;
 
@@ -4301,6 +4450,7 @@ void lp_load_mip_start(LinearProgram *lp, int count, const char **colNames, cons
     }
     if (lp->msIdx)
         delete[] lp->msIdx;
+    lp->msIdx = NULL;
     if (lp->msVal)
         delete[] lp->msVal;
 
@@ -4323,6 +4473,29 @@ void lp_load_mip_start(LinearProgram *lp, int count, const char **colNames, cons
 #endif
 }
 
+void lp_add_mip_start( LinearProgram *lp, int count, const char **colNames, const double *colValues )
+{
+    vector< int > idx;
+    vector< double > val;
+    idx.reserve( count );
+    val.reserve( count );
+    for ( int i=0 ; (i<count) ; ++i )
+    {
+        int col = lp_col_index( lp, colNames[i] );
+        if (col<0)
+        {
+            if (!lp->silent)
+                printf("MIPStart warning: variable %s not found.\n", colNames[i] );
+            continue;
+        }
+        idx.push_back( col );
+        val.push_back( colValues[i] );
+    }
+
+    lp->_msAddIdx->push_back( idx );
+    lp->_msAddVal->push_back( val );
+}
+
 void lp_chg_obj(LinearProgram *lp, int count, int idx[], double obj[])
 {
 #ifdef GRB
@@ -4332,8 +4505,8 @@ void lp_chg_obj(LinearProgram *lp, int count, int idx[], double obj[])
     lp->nModelChanges++;
 #endif
 #ifdef CPX
-    int cpxError = CPXchgobj(LPcpxDefaultEnv, lp->cpxLP, count, idx, obj);
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXchgobj(lp->cpxEnv, lp->cpxLP, count, idx, obj);
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef CBC
     for (int i=0 ; (i<count) ; i++ )
@@ -4345,7 +4518,7 @@ int lp_nz(LinearProgram *lp)
 {
     assert(lp);
 #ifdef CPX
-    return CPXgetnumnz(LPcpxDefaultEnv, lp->cpxLP);
+    return CPXgetnumnz(lp->cpxEnv, lp->cpxLP);
 #endif
 #ifdef CBC
     return lp->_lp->getNumElements();
@@ -4445,26 +4618,33 @@ int lp_read_mip_start( LinearProgram *lp, const char *fileName )
     else
         printf("LP: no mipstart solution read from %s.\n", fileName );
 
+    /* same allocator of lp_load_mip_start and lp_free */
     if (lp->msNames)
     {
-        free( lp->msNames[0] );
-        free( lp->msNames );
+        delete[] lp->msNames[0];
+        delete[] lp->msNames;
     }
+    if (lp->msIdx)
+        delete[] lp->msIdx;
+    lp->msIdx = NULL;
     if (lp->msVal)
-        free( lp->msVal );
+        delete[] lp->msVal;
 
     int totalChars = 0;
     for ( int i=0 ; (i<(int)cNames.size()) ; ++i )
         totalChars += cNames[i].size()+1;
 
-    lp->msVal = (double*) malloc( sizeof(double)*cNames.size() );
-    lp->msNames = (char**) malloc( sizeof(char*)*(cNames.size()+1) );
-    lp->msNames[0] = (char*) malloc( sizeof(char)*totalChars );
+    lp->msVal = new double[cNames.size()];
+    lp->msNames = new char*[cNames.size()+1];
+    lp->msNames[0] = new char[totalChars];
     for ( int i=1 ; (i<(int)cNames.size()) ; ++i )
         lp->msNames[i] = lp->msNames[i-1] + cNames[i-1].size()+1;
 
     for ( int i=0 ; (i<(int)cNames.size()) ; ++i )
+    {
         strcpy( lp->msNames[i], cNames[i].c_str() );
+        lp->msVal[i] = cValues[i];
+    }
 
     lp->msVars = cNames.size();
 
@@ -4734,8 +4914,8 @@ void lp_remove_row( LinearProgram *lp, int idxRow )
     lp->nModelChanges++;
 #endif
 #ifdef CPX
-    int cpxError = CPXdelrows( LPcpxDefaultEnv, lp->cpxLP, idxRow, idxRow );
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+    int cpxError = CPXdelrows( lp->cpxEnv, lp->cpxLP, idxRow, idxRow );
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
 #endif
 #ifdef CBC
     int idx = idxRow;
@@ -4882,8 +5062,8 @@ void lp_remove_rows( LinearProgram *lp, int nRows, int *rows )
     for ( int i=0 ; (i<nRows) ; ++i )
         rset[rows[i]] = 1;
     int cpxError = 
-        CPXdelsetrows( LPcpxDefaultEnv, lp->cpxLP, rset );
-    lp_check_for_cpx_error(LPcpxDefaultEnv, cpxError, __FILE__, __LINE__);
+        CPXdelsetrows( lp->cpxEnv, lp->cpxLP, rset );
+    lp_check_for_cpx_error(lp->cpxEnv, cpxError, __FILE__, __LINE__);
     free( rset );
 #endif
 #ifdef GLPK
@@ -81,6 +81,16 @@ LinearProgram *lp_create();
 LinearProgram *lp_clone( LinearProgram *lp );
 
 
+/** @brief Clones the problem in lp into a new solver environment
+ *
+ * With CPLEX the clone has its own environment, so that it can be optimized
+ * in a different thread than lp, each one with its own parameters. The
+ * environment is closed by lp_free. Gurobi models already have their own
+ * environment and for the other solvers this is the same as lp_clone.
+ **/
+LinearProgram *lp_clone_own_env( LinearProgram *lp );
+
+
 /** @brief Reads a .lp or .mps file in fileName to object lp
  **/
 void lp_read( LinearProgram *lp, const char *fileName );
@@ -266,6 +276,26 @@ void lp_set_integer( LinearProgram *lp, int nCols, int cols[] );
  **/
 void lp_write_sol( LinearProgram *lp, const char *fileName );
 
+/** @brief Saves the incumbent solution in fileName, as lp_write_sol, replacing it only when complete
+ *
+ * The solution is written to fileName.tmp, which is then renamed to fileName, so that an interrupted run
+ * never leaves an incomplete solution (e.g. a checkpoint) in fileName.
+ *
+ * @param lp the (integer) linear program
+ * @param fileName file name where the solution will be saved
+ **/
+void lp_write_sol_atomic( LinearProgram *lp, const char *fileName );
+
+/** @brief Saves x, a feasible solution of lp not necessarily found by the solver, in fileName,
+ * in the format of lp_write_sol and replacing it only when complete, as lp_write_sol_atomic
+ *
+ * @param lp the (integer) linear program
+ * @param fileName file name where the solution will be saved
+ * @param x values of all columns
+ * @param objValue objective value of x
+ **/
+void lp_write_x_atomic( LinearProgram *lp, const char *fileName, const double *x, double objValue );
+
 
 /** @brief Enters a initial feasible solution for the problem. Variables are referenced by their names. Only the main decision variables need to be informed.
  * @param lp the (integer) linear program
@@ -283,6 +313,16 @@ void lp_load_mip_start(LinearProgram *lp, int count, const char **colNames, cons
  */
 void lp_load_mip_starti( LinearProgram *lp, int count, const int *colIndexes, const double *colValues );
 
+/** @brief Enters one more initial feasible solution, tried by the solver after the one
+ * of lp_load_mip_start. Can be called several times before lp_optimize, all solutions
+ * are passed to the solver in the next optimization. Only used with CPLEX.
+ * @param lp the (integer) linear program
+ * @param count number of variables whose value will be informed
+ * @param colNames column names
+ * @param colValues column values
+ **/
+void lp_add_mip_start( LinearProgram *lp, int count, const char **colNames, const double *colValues );
+
 
 /** @brief Loads from fileName an initial feasible solution.
  *
@@ -503,6 +543,14 @@ void lp_set_abs_mip_gap( LinearProgram *lp, const double _value );
 void lp_set_rel_mip_gap( LinearProgram *lp, const double _value );
 /* parameters - parallel */
 void lp_set_parallel( LinearProgram *lp, char onOff );
+/* parameters - random seed and number of threads of
+ * the solver, only used with CPLEX and Gurobi */
+void lp_set_seed( LinearProgram *lp, int seed );
+void lp_set_threads( LinearProgram *lp, int threads );
+/* parameters - the optimization stops as soon as possible once
+ * *terminate is set to a nonzero value, e.g. by another thread.
+ * only used with CPLEX, where it applies to the whole environment */
+void lp_set_terminate( LinearProgram *lp, volatile int *terminate );
 
 /** @defgroup groupQuery Query problem information
  *  
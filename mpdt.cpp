@@ -11,6 +11,11 @@
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <vector>
+#include <ctime>
+#include <climits>
+#include <string>
+#include <omp.h>
 
 #include "InstanceSet.hpp"
 #include "MIPPDtree.hpp"
@@ -18,10 +23,29 @@
 #include "ResultsSet.hpp"
 #include "Tree.hpp"
 #include "Greedy.hpp"
+#include "DPTree.hpp"
 #include "MIPSelAlg.hpp"
+#include "HeurSelAlg.hpp"
+#include "Node.hpp"
+#include "Coreset.hpp"
 
 using namespace std;
 
+// the MIP solver builds the first hybridLevels branching levels,
+// then the subtree of each of its leafs is built by the dynamic
+// programming solver, using only the instances of the leaf
+static Tree *buildHybrid( const InstanceSet *iset, const ResultsSet *rset );
+
+// solves the MIP for increasing depths, starting each one from the
+// cheapest of the previous depth tree and the greedy tree. greedyT
+// is the greedy tree of maxDepth, deleted if not returned
+static Tree *buildIterDeepening( const InstanceSet *iset, const ResultsSet *rset, Tree *greedyT );
+
+// selects Parameters::maxAlgs algorithms as selalg does, in
+// selAlgFraction of maxSeconds, returning the results of these
+// algorithms
+static ResultsSet *selectAlgs( const ResultsSet *rset );
+
 int main( int argc, char **argv )
 {
     if (argc<3)
@@ -34,6 +58,8 @@ int main( int argc, char **argv )
     Parameters::print();
     cout << endl;
 
+    const double startT = omp_get_wtime();
+
     cout << "reading instances ... " << endl;
     InstanceSet iset( argv[1], argv[2] );
     if (Parameters::isetCSVNorm.size())
@@ -56,30 +82,347 @@ int main( int argc, char **argv )
         Parameters::minElementsBranch = newMEB;
     }    
 
-    rset.print_summarized_results();
+    const double readT = omp_get_wtime();
+
+    // with selAlgPipeline, the tree is built with the results of the
+    // selected algorithms, projected from the results read
+    ResultsSet *selRSet = nullptr;
+    if (Parameters::selAlgPipeline)
+        selRSet = selectAlgs( &rset );
+    ResultsSet *rs = selRSet ? selRSet : &rset;
+    const double selT = omp_get_wtime();
+    // the tree solvers get the time left by the selection
+    if (Parameters::selAlgPipeline)
+        Parameters::maxSeconds = std::max( 1.0, Parameters::maxSeconds-(selT-readT) );
+
+    rs->print_summarized_results();
 
-    Greedy grd(&iset, &rset);
+    Greedy grd(&iset, rs);
     Tree *greedyT = grd.build();
+    // other cheapest trees of the portfolio, more starts for the MIP
+    vector< Tree * > moreStarts;
+    if (Parameters::greedyPortfolio>0)
+    {
+        moreStarts = grd.buildPortfolio( greedyT, Parameters::greedyPortfolio, Parameters::greedyStarts );
+        greedyT = moreStarts[0];
+        moreStarts.erase( moreStarts.begin() );
+    }
+
     if (Parameters::gtreeFile.size())
         greedyT->save(Parameters::gtreeFile.c_str());
     if (Parameters::gtreeFileGV.size())
         greedyT->draw(Parameters::gtreeFileGV.c_str());
 
+    const double greedyT_ = omp_get_wtime();
+
+    // with anytime search, a tree is always available in treeFile
+    if (!Parameters::onlyGreedy && Parameters::anytime>0)
+        greedyT->saveFiles();
+
+    // the coreset is only used by the MIP of maxDepth
+    if (Parameters::coreset>0 && !Parameters::onlyGreedy && (Parameters::exactDP || Parameters::iterDeepening ||
+            (Parameters::hybridLevels>0 && Parameters::hybridLevels<((int)Parameters::maxDepth)-1)))
+        cerr << "warning: -coreset is ignored with -exactDP, -hybridLevels and -iterDeepening, all instances are used" << endl;
+
+    const Tree *tree = nullptr;
     if (Parameters::onlyGreedy)
-        return 0;
+        delete greedyT;
+    else if (Parameters::exactDP)
+    {
+        DPTree dpt( &iset, rs );
+        dpt.setInitialSolution( greedyT );
+        delete greedyT;
 
-    MIPPDtree mpdt( &iset, &rset );
-    mpdt.setInitialSolution( greedyT );
-    delete greedyT;
+        tree = dpt.build( Parameters::maxSeconds );
+    }
+    else if (Parameters::hybridLevels>0 && Parameters::hybridLevels<((int)Parameters::maxDepth)-1)
+    {
+        delete greedyT;
+        tree = buildHybrid( &iset, rs );
+    }
+    else if (Parameters::iterDeepening)
+        tree = buildIterDeepening( &iset, rs, greedyT );
+    else
+    {
+        Coreset *coreset = nullptr;
+        if (Parameters::coreset>0 && Parameters::coreset<iset.nGroups())
+        {
+            coreset = new Coreset( &iset, rs, Parameters::coreset );
+            iset.setGroups( coreset->groups() );
+        }
+        const double greedyCost = greedyT->cost();
+
+        MIPPDtree mpdt( &iset, rs );
+        mpdt.setInitialSolution( greedyT );
+        for ( const Tree *st : moreStarts )
+            mpdt.addInitialSolution( st );
+        delete greedyT;
+        if (Parameters::resume)
+            mpdt.resume();
 
-    const Tree *tree = mpdt.build( Parameters::maxSeconds );
+        Tree *mipT = mpdt.build( Parameters::maxSeconds );
+        if (coreset && mipT)
+        {
+            Tree *refT = coreset->refine( mipT );
+            cout << "cost in all instances: coreset tree " << mipT->cost() << ", refined tree " << refT->cost() <<
+                ", greedy tree " << greedyCost << ", gap to greedy " <<
+                100.0*(refT->cost()-greedyCost)/greedyCost << "%" << endl;
+            delete mipT;
+            mipT = refT;
+        }
+        delete coreset;
+        tree = mipT;
+    }
+    for ( Tree *st : moreStarts )
+        delete st;
     if (tree)
+        tree->saveFiles();
+
+    const double endT = omp_get_wtime();
+    cout << fixed << setprecision(2) << "times (s): reading " << readT-startT;
+    if (selRSet)
+        cout << ", algorithm selection " << selT-readT;
+    cout << ", greedy " << greedyT_-selT;
+    if (!Parameters::onlyGreedy)
+        cout << ", tree " << endT-greedyT_;
+    cout << ", total " << endT-startT << endl;
+    cout << defaultfloat;
+
+    delete selRSet;
+
+    exit(0);
+}
+
+// fileName with _d<depth> before its extension
+static string depthFileName( const string &fileName, size_t depth )
+{
+    const string suffix = "_d" + to_string(depth);
+    const size_t pos = fileName.find_last_of( '.' );
+    if (pos == string::npos || fileName.find( '/', pos ) != string::npos)
+        return fileName + suffix;
+
+    return fileName.substr( 0, pos ) + suffix + fileName.substr( pos );
+}
+
+static Tree *buildIterDeepening( const InstanceSet *iset, const ResultsSet *rset, Tree *greedyT )
+{
+    const time_t startT = time(nullptr);
+    const size_t maxDepth = Parameters::maxDepth;
+
+    // tree of the deepest MIP solved so far
+    Tree *best = nullptr;
+    for ( size_t depth=2 ; (depth<=maxDepth) ; ++depth )
     {
+        const double elapsed = difftime( time(nullptr), startT );
+        if (depth>2 && elapsed>=Parameters::maxSeconds)
+            break;
+
+        // the time left is shared by this and the next depths, in
+        // proportion to their number of leafs: time not used by a
+        // depth goes to the next ones
+        double weightLeft = 0.0;
+        for ( size_t dn=depth ; (dn<=maxDepth) ; ++dn )
+            weightLeft += pow( 2.0, (double)dn );
+        const double left = std::max( 1.0, Parameters::maxSeconds - elapsed );
+        const int depthSeconds = std::max( 1, (int)(left*pow( 2.0, (double)depth )/weightLeft) );
+
+        Parameters::maxDepth = depth;
+        Tree *grdT = greedyT;
+        if (depth<maxDepth)
+        {
+            Greedy grd( iset, rset );
+            grdT = grd.build();
+        }
+
+        // a shallower tree is a solution for depth with unused leafs
+        const Tree *start = grdT;
+        if (best && best->cost()<=grdT->cost())
+            start = best;
+        cout << "depth " << depth << ": starting from the " << ((start==best) ? "previous depth" : "greedy") <<
+            " tree of cost " << start->cost() << ", " << depthSeconds << " seconds" << endl;
+
+        Tree *tree = nullptr;
+        {
+            MIPPDtree mpdt( iset, rset );
+            mpdt.setInitialSolution( start );
+            tree = mpdt.build( depthSeconds );
+        }
+        if (grdT != greedyT)
+            delete grdT;
+
+        if (tree)
+        {
+            delete best;
+            best = tree;
+        }
+        if (best == nullptr)
+            continue;
+
+        cout << "depth " << depth << ": tree of cost " << best->cost() << ", " <<
+            difftime( time(nullptr), startT ) << " seconds" << endl;
         if (Parameters::treeFile.size())
-            tree->save(Parameters::treeFile.c_str());
+            best->save( depthFileName( Parameters::treeFile, depth ).c_str() );
         if (Parameters::treeFileGV.size())
-            tree->draw(Parameters::treeFileGV.c_str());
+            best->draw( depthFileName( Parameters::treeFileGV, depth ).c_str() );
     }
+    Parameters::maxDepth = maxDepth;
 
-    exit(0);
+    // time limit reached before maxDepth
+    if (best == nullptr || greedyT->cost()<best->cost())
+    {
+        delete best;
+        return greedyT;
+    }
+    delete greedyT;
+
+    return best;
+}
+
+static Tree *buildHybrid( const InstanceSet *iset, const ResultsSet *rset )
+{
+    const time_t startT = time(nullptr);
+    const size_t maxDepth = Parameters::maxDepth;
+    const int anytime = Parameters::anytime;
+
+    // top tree: trees saved by the MIP solver would be incomplete
+    Parameters::maxDepth = Parameters::hybridLevels+1;
+    Parameters::anytime = 0;
+    Tree *tree = nullptr;
+    {
+        Greedy grd( iset, rset );
+        Tree *greedyT = grd.build();
+
+        // leafs of the top tree are estimated by their subtrees
+        const int subLevels = Parameters::hybridEstimate ? ((int)maxDepth)-((int)Parameters::maxDepth) : 0;
+        MIPPDtree mpdt( iset, rset, subLevels );
+        mpdt.setInitialSolution( greedyT );
+        delete greedyT;
+
+        const int mipSeconds = std::max( 1, (int)(Parameters::hybridMIPFraction*Parameters::maxSeconds) );
+        tree = mpdt.build( mipSeconds );
+    }
+    Parameters::maxDepth = maxDepth;
+    Parameters::anytime = anytime;
+
+    if (tree == nullptr)
+    {
+        tree = new Tree( iset, rset );
+        tree->create_root();
+    }
+
+    vector< Node * > leafs, queue;
+    queue.push_back( tree->root() );
+    while (queue.size())
+    {
+        Node *node = queue.back();
+        queue.pop_back();
+        if (node->isLeaf())
+            leafs.push_back( node );
+        else
+        {
+            queue.push_back( node->child()[0] );
+            queue.push_back( node->child()[1] );
+        }
+    }
+    // larger subproblems first
+    std::sort( leafs.begin(), leafs.end(), [] ( const Node *n1, const Node *n2 ) {
+        return n1->n_elements() > n2->n_elements(); } );
+
+    // all subtrees share the remaining time, with at least one second
+    const double remaining = std::max( 1.0, Parameters::maxSeconds - difftime( time(nullptr), startT ) );
+    const double deadline = omp_get_wtime() + remaining;
+
+    const int nThreads = std::min( (int)leafs.size(),
+            (Parameters::threads>=1) ? Parameters::threads : omp_get_num_procs() );
+    cout << "building subtrees of " << leafs.size() << " leafs using " << nThreads << " threads" << endl;
+
+    // preprocessing is done once, other threads only allocate their search data
+    vector< DPTree * > dpts;
+    dpts.push_back( new DPTree( iset, rset ) );
+    for ( int it=1 ; (it<nThreads) ; ++it )
+        dpts.push_back( new DPTree( dpts[0] ) );
+
+    // nodes are added to the tree after the parallel region
+    vector< Tree * > subtrees;
+    for ( size_t i=0 ; (i<leafs.size()) ; ++i )
+        subtrees.push_back( new Tree( iset, rset ) );
+    vector< char > expanded( leafs.size(), 0 );
+
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+    for ( int i=0 ; i<(int)leafs.size() ; ++i )
+    {
+        const int levels = ((int)maxDepth)-1-leafs[i]->depth();
+        expanded[i] = dpts[omp_get_thread_num()]->expandNode( subtrees[i], leafs[i], levels, deadline );
+    }
+
+    // leafs not solved in time get greedy subtrees
+    int nTimeUp = 0;
+    Greedy *grd = nullptr;
+    for ( size_t i=0 ; (i<leafs.size()) ; ++i )
+    {
+        if (expanded[i])
+            continue;
+        ++nTimeUp;
+        if (grd == nullptr)
+            grd = new Greedy( iset, rset );
+        grd->expandNode( subtrees[i], leafs[i] );
+    }
+    delete grd;
+
+    for ( size_t i=0 ; (i<leafs.size()) ; ++i )
+    {
+        queue.push_back( leafs[i] );
+        while (queue.size())
+        {
+            Node *node = queue.back();
+            queue.pop_back();
+            if (node->isLeaf())
+                continue;
+            for ( int c=0 ; (c<2) ; ++c )
+            {
+                tree->addNode( node->child()[c] );
+                queue.push_back( node->child()[c] );
+            }
+        }
+        delete subtrees[i];
+    }
+    // the first solver owns the shared data
+    for ( int it=nThreads-1 ; (it>=0) ; --it )
+        delete dpts[it];
+
+    tree->computeCost();
+    cout << "hybrid tree of cost " << tree->cost() << " built in " << difftime( time(nullptr), startT ) << " seconds";
+    if (nTimeUp)
+        cout << ", time limit reached in " << nTimeUp << " subtrees, built by the greedy constructive";
+    cout << endl;
+
+    return tree;
+}
+
+static ResultsSet *selectAlgs( const ResultsSet *rset )
+{
+    const int maxSeconds = std::max( 1, (int)(Parameters::selAlgFraction*Parameters::maxSeconds) );
+    vector< int > algs;
+    if (Parameters::selAlgHeur)
+    {
+        HeurSelAlg hsa( rset );
+        hsa.optimize( maxSeconds );
+        algs = vector< int >( hsa.selAlg(), hsa.selAlg()+hsa.nSelAlg() );
+    }
+    else
+    {
+        MIPSelAlg msa( rset );
+        msa.optimize( maxSeconds );
+        algs = vector< int >( msa.selAlg(), msa.selAlg()+msa.nSelAlg() );
+    }
+
+    if (algs.empty())
+    {
+        cerr << "no algorithms selected, building the tree with all of them" << endl;
+        return nullptr;
+    }
+    sort( algs.begin(), algs.end() );
+    cout << algs.size() << " of " << rset->algsettings().size() << " algorithms selected" << endl;
+
+    return new ResultsSet( *rset, algs );
 }
@@ -0,0 +1,254 @@
+/*
+ * mvpdt.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cfloat>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <omp.h>
+
+#include "InstanceSet.hpp"
+#include "Parameters.hpp"
+#include "ResultsSet.hpp"
+#include "Tree.hpp"
+#include "Greedy.hpp"
+#include "ObliqueSplit.hpp"
+
+using namespace std;
+
+// node of a multivariate tree: branch nodes send instances with
+// sum_f coef[f]*x[f] > rhs, over the normalized feature ranks,
+// to child[1]
+struct MVNode
+{
+    vector< int > el;
+    size_t depth;
+    vector< double > coef;
+    double rhs;
+    int child[2];
+    int bestAlg;
+
+    // sum of results (as evaluated in the search)
+    // of bestAlg and average original result
+    double cost;
+    double avOrigRes;
+};
+
+// cheapest algorithm for instances el, returns its cost
+static double bestAlgorithm( const ResultsSet *rset, const vector< int > &el, int *alg );
+
+// branches nodes while they are above maxDepth and some oblique split
+// improves them, nodes are stored in breadth first order
+static vector< MVNode > buildTree( const InstanceSet *iset, const ResultsSet *rset );
+
+static void printTree( const InstanceSet *iset, const ResultsSet *rset, const vector< MVNode > &nodes );
+
+static void drawTree( const InstanceSet *iset, const ResultsSet *rset, const vector< MVNode > &nodes, const char *fileName );
+
+int main( int argc, char **argv )
+{
+    if (argc<3)
+    {
+        fprintf(stderr, "usage: mvpdt instanceSet resultsSet [options]");
+        exit(1);
+    }
+
+    Parameters::parse( argc, (const char **)argv );
+    Parameters::print();
+    cout << endl;
+
+    cout << "reading instances ... " << endl;
+    InstanceSet iset( argv[1], argv[2] );
+    cout << endl;
+
+    cout << "reading results ... " << endl;
+    ResultsSet rset( iset, argv[2] );
+    cout << endl;
+
+    int newMEB = (int) ceil(((double)iset.size())*((double)Parameters::minPercElementsBranch));
+    if (newMEB>Parameters::minElementsBranch)
+    {
+        cout << "minElementsBranch increased to " << newMEB << defaultfloat <<
+            setprecision(3) << ", " << Parameters::minPercElementsBranch*100.0 << "\% of instance set size" << endl;
+        Parameters::minElementsBranch = newMEB;
+    }
+
+    Greedy grd(&iset, &rset);
+    Tree *greedyT = grd.build();
+    const double greedyCost = greedyT->cost();
+    if (Parameters::gtreeFile.size())
+        greedyT->save(Parameters::gtreeFile.c_str());
+    if (Parameters::gtreeFileGV.size())
+        greedyT->draw(Parameters::gtreeFileGV.c_str());
+    delete greedyT;
+
+    const double startT = omp_get_wtime();
+    vector< MVNode > nodes = buildTree( &iset, &rset );
+    const double secs = omp_get_wtime()-startT;
+
+    // average original result, as Tree::cost
+    double cost = 0.0;
+    for ( const auto &node : nodes )
+        if (node.child[0]==-1)
+            cost += node.avOrigRes*node.el.size();
+    cost /= (double)iset.size();
+
+    printTree( &iset, &rset, nodes );
+    cout << "multivariate tree with " << nodes.size() << " nodes and cost " << cost << " built in " <<
+        setprecision(3) << secs << " seconds, greedy tree cost " << greedyCost << defaultfloat << endl;
+
+    if (Parameters::treeFileGV.size())
+        drawTree( &iset, &rset, nodes, Parameters::treeFileGV.c_str() );
+
+    exit(0);
+}
+
+static double bestAlgorithm( const ResultsSet *rset, const vector< int > &el, int *alg )
+{
+    double best = DBL_MAX;
+    for ( size_t ia=0 ; (ia<rset->algsettings().size()) ; ++ia )
+    {
+        double sum = 0.0;
+        for ( const auto i : el )
+            sum += rset->res(i, ia);
+        if (sum<best)
+        {
+            best = sum;
+            *alg = ia;
+        }
+    }
+
+    return best;
+}
+
+static vector< MVNode > buildTree( const InstanceSet *iset, const ResultsSet *rset )
+{
+    const double endTime = omp_get_wtime() + Parameters::maxSeconds;
+
+    vector< MVNode > nodes( 1 );
+    for ( int i=0 ; (i<iset->size()) ; ++i )
+        nodes[0].el.push_back( i );
+    nodes[0].depth = 0;
+
+    ObliqueSplit os( iset, rset );
+    for ( size_t in=0 ; (in<nodes.size()) ; ++in )
+    {
+        MVNode &node = nodes[in];
+        node.child[0] = node.child[1] = -1;
+        node.rhs = 0.0;
+        node.cost = bestAlgorithm( rset, node.el, &node.bestAlg );
+        node.avOrigRes = 0.0;
+        for ( const auto i : node.el )
+            node.avOrigRes += rset->origRes(i, node.bestAlg);
+        node.avOrigRes /= (double)node.el.size();
+
+        if (node.depth+1>=Parameters::maxDepth || node.el.size()<2*(size_t)Parameters::minElementsBranch)
+            continue;
+
+        const double remaining = endTime - omp_get_wtime();
+        if (remaining<=0.0)
+            continue;
+
+        const double startT = omp_get_wtime();
+        if (!os.search( node.el, remaining ) || os.cost()>=node.cost-1e-9)
+            continue;
+        cout << "node " << in << " (" << node.el.size() << " instances): oblique split of cost " << os.cost() <<
+            ", axis parallel " << os.axisCost() << ", no split " << node.cost << ", " <<
+            setprecision(3) << (omp_get_wtime()-startT)*1000.0 << " ms" << defaultfloat << endl;
+
+        MVNode children[2];
+        for ( const auto i : node.el )
+            children[os.side( i )].el.push_back( i );
+
+        node.coef = os.coef();
+        node.rhs = os.rhs();
+        for ( int s=0 ; (s<2) ; ++s )
+        {
+            node.child[s] = nodes.size()+s;
+            children[s].depth = node.depth+1;
+        }
+
+        // node may be invalidated
+        nodes.push_back( children[0] );
+        nodes.push_back( children[1] );
+    }
+
+    return nodes;
+}
+
+// hyperplane with the features of non-negligible coefficients
+static string hyperplane( const InstanceSet *iset, const MVNode &node )
+{
+    double maxC = 0.0;
+    for ( const auto c : node.coef )
+        maxC = max( maxC, fabs(c) );
+
+    string res;
+    char str[256];
+    for ( size_t f=0 ; (f<node.coef.size()) ; ++f )
+    {
+        if (fabs(node.coef[f])<=1e-3*maxC)
+            continue;
+        sprintf( str, "%s%g*%s", (res.size() ? " + " : ""), node.coef[f], iset->features()[f].c_str() );
+        res += str;
+    }
+    sprintf( str, " > %g", node.rhs );
+    res += str;
+
+    return res;
+}
+
+static void printTree( const InstanceSet *iset, const ResultsSet *rset, const vector< MVNode > &nodes )
+{
+    for ( size_t in=0 ; (in<nodes.size()) ; ++in )
+    {
+        const MVNode &node = nodes[in];
+        cout << string( 2*node.depth, ' ' ) << "node " << in << ", " << node.el.size() << " instances, ";
+        if (node.child[0]==-1)
+            cout << "algorithm " << rset->algsettings()[node.bestAlg] << endl;
+        else
+            cout << "right (node " << node.child[1] << ") if " << hyperplane( iset, node ) <<
+                ", otherwise node " << node.child[0] << endl;
+    }
+}
+
+static void drawTree( const InstanceSet *iset, const ResultsSet *rset, const vector< MVNode > &nodes, const char *fileName )
+{
+    const string tmpName = string(fileName) + ".tmp";
+    ofstream of(tmpName.c_str());
+    of << "digraph G {" << endl;
+    of << " graph [fontname = \"helvetica\"];" << endl;
+    of << " node [fontname = \"helvetica\" shape=\"box\"];" << endl;
+    of << " edge [fontname = \"helvetica\"];" << endl;
+
+    for ( size_t in=0 ; (in<nodes.size()) ; ++in )
+    {
+        const MVNode &node = nodes[in];
+        of << "  n" << in << " [label=\"" << node.el.size() << " instances\\n";
+        if (node.child[0]==-1)
+            of << rset->algsettings()[node.bestAlg] << "\\n" << node.avOrigRes;
+        else
+            of << hyperplane( iset, node );
+        of << "\"];" << endl;
+    }
+    for ( size_t in=0 ; (in<nodes.size()) ; ++in )
+    {
+        const MVNode &node = nodes[in];
+        if (node.child[0]==-1)
+            continue;
+        of << "  n" << in << " -> n" << node.child[0] << " [label=\"no\"];" << endl;
+        of << "  n" << in << " -> n" << node.child[1] << " [label=\"yes\"];" << endl;
+    }
+    of << "}" << endl;
+    of.close();
+
+    if (rename( tmpName.c_str(), fileName ))
+        cerr << "could not write " << fileName << endl;
+}
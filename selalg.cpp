@@ -19,6 +19,7 @@
 #include "Tree.hpp"
 #include "Greedy.hpp"
 #include "MIPSelAlg.hpp"
+#include "HeurSelAlg.hpp"
 
 using namespace std;
 
@@ -56,14 +57,43 @@ int main( int argc, char **argv )
         Parameters::minElementsBranch = newMEB;
     }    
 
+    // with minAlgs, a sweep from maxAlgs down to minAlgs
+    const int maxAlgs = Parameters::maxAlgs;
+    const int minAlgs = Parameters::minAlgs>0 ? min(Parameters::minAlgs, maxAlgs) : maxAlgs;
+
+    if (Parameters::selAlgHeur)
+    {
+        for ( int k=maxAlgs ; (k>=minAlgs) ; --k )
+        {
+            Parameters::maxAlgs = k;
+            string fileName = "res-" + to_string(rset.algsettings().size()) +
+                    "-" + to_string(k)  + ".csv";
+            HeurSelAlg hsa(&rset);
+            hsa.optimize(Parameters::maxSeconds);
+            hsa.saveFilteredResults(fileName.c_str());
+        }
+        exit(0);
+    }
+
     MIPSelAlg msa(&rset);
 
-    msa.optimize(Parameters::maxSeconds);
+    for ( int k=maxAlgs ; (k>=minAlgs) ; --k )
+    {
+        string fileName = "res-" + to_string(rset.algsettings().size()) +
+                "-" + to_string(k)  + ".csv";
+        if (k<maxAlgs)
+        {
+            cout << endl << "selecting " << k << " algorithms" << endl;
+            msa.setMaxAlgs(k);
+        }
+        // each k has its own checkpoint, used instead of the warm start
+        if (Parameters::resume)
+            msa.resume();
 
-    string fileName = "res-" + to_string(rset.algsettings().size()) + 
-            "-" + to_string(Parameters::maxAlgs)  + ".csv";
-    
-    msa.saveFilteredResults(fileName.c_str());
+        msa.optimize(Parameters::maxSeconds);
+
+        msa.saveFilteredResults(fileName.c_str());
+    }
 
     exit(0);
 }
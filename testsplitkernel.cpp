@@ -0,0 +1,252 @@
+/*
+ * testsplitkernel.cpp
+ *
+ * checks the vectorized split kernels supported by the
+ * CPU against the scalar version, results must be identical,
+ * and the split selected by the greedy with each kernel
+ * against a scan with long double sums
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cfloat>
+#include <climits>
+#include <limits>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+
+#include "SplitKernel.hpp"
+#include "InstanceSet.hpp"
+#include "ResultsSet.hpp"
+#include "Parameters.hpp"
+#include "Greedy.hpp"
+#include "Tree.hpp"
+#include "Node.hpp"
+
+using namespace std;
+
+// expected results, computed without the kernels
+static void ref_add( vector< double > &sum, const vector< double > &row )
+{
+    for ( size_t i=0 ; (i<sum.size()) ; ++i )
+        sum[i] += row[i];
+}
+
+static void ref_min_lr( const vector< double > &sumL, const vector< double > &tot,
+                        double *minL, double *minR )
+{
+    *minL = *minR = DBL_MAX;
+    for ( size_t i=0 ; (i<sumL.size()) ; ++i )
+    {
+        *minL = min( *minL, sumL[i] );
+        *minR = min( *minR, tot[i]-sumL[i] );
+    }
+}
+
+// checks implementation name for all sizes up to maxN, so that
+// the vector loops and their remainders are exercised
+static int check( const char *name, size_t maxN )
+{
+    mt19937 rng( 1 );
+    uniform_real_distribution< double > dist( -1000.0, 1000.0 );
+
+    int errors = 0;
+    for ( size_t n=0 ; (n<=maxN) ; ++n )
+    {
+        vector< double > row( n ), tot( n ), sum( n ), exp( n );
+        for ( size_t i=0 ; (i<n) ; ++i )
+        {
+            row[i] = dist( rng );
+            tot[i] = dist( rng );
+            sum[i] = exp[i] = dist( rng );
+        }
+
+        split_kernel_add( n ? &sum[0] : nullptr, n ? &row[0] : nullptr, n );
+        ref_add( exp, row );
+        if (sum != exp)
+        {
+            fprintf( stderr, "%s: split_kernel_add differs for n=%zu\n", name, n );
+            ++errors;
+        }
+
+        split_kernel_sub( n ? &sum[0] : nullptr, n ? &row[0] : nullptr, n );
+        for ( size_t i=0 ; (i<n) ; ++i )
+            exp[i] -= row[i];
+        if (sum != exp)
+        {
+            fprintf( stderr, "%s: split_kernel_sub differs for n=%zu\n", name, n );
+            ++errors;
+        }
+
+        double minL, minR, expL, expR;
+        split_kernel_min_lr( n ? &sum[0] : nullptr, n ? &tot[0] : nullptr, n, &minL, &minR );
+        ref_min_lr( sum, tot, &expL, &expR );
+        if (minL != expL || minR != expR)
+        {
+            fprintf( stderr, "%s: split_kernel_min_lr differs for n=%zu\n", name, n );
+            ++errors;
+        }
+    }
+
+    return errors;
+}
+
+// fixture: instances whose features are multiples of 1/32, so that
+// there are ties, and results where algorithm 1 is the best one for
+// instances with f2<=0.5 and algorithm 5 for the other ones, with
+// noise. files are written in temporary files featFile and resFile
+static void write_fixture( string &featFile, string &resFile )
+{
+    const int nInsts = 240, nFeatures = 6, nAlgs = 8;
+    mt19937 rng( 7 );
+    uniform_int_distribution< int > fv( 0, 31 );
+    uniform_real_distribution< double > noise( 0.0, 1.0 );
+
+    char fName[] = "/tmp/tskfeatXXXXXX";
+    char rName[] = "/tmp/tskresXXXXXX";
+    close( mkstemp( fName ) );
+    close( mkstemp( rName ) );
+    featFile = fName;
+    resFile = rName;
+
+    FILE *ff = fopen( fName, "w" );
+    FILE *fr = fopen( rName, "w" );
+    fprintf( ff, "instance" );
+    for ( int f=0 ; (f<nFeatures) ; ++f )
+        fprintf( ff, ",f%d", f );
+    fprintf( ff, "\n" );
+    fprintf( fr, "instance,algsetting,result\n" );
+    for ( int i=0 ; (i<nInsts) ; ++i )
+    {
+        vector< double > feat( nFeatures );
+        fprintf( ff, "i%d", i );
+        for ( int f=0 ; (f<nFeatures) ; ++f )
+        {
+            feat[f] = fv( rng )/32.0;
+            fprintf( ff, ",%g", feat[f] );
+        }
+        fprintf( ff, "\n" );
+
+        const int bestAlg = (feat[2]<=0.5) ? 1 : 5;
+        for ( int a=0 ; (a<nAlgs) ; ++a )
+            fprintf( fr, "i%d,a%d,%.4f\n", i, a, ((a==bestAlg) ? 1.0 : 2.0) + noise( rng ) );
+    }
+    fclose( ff );
+    fclose( fr );
+}
+
+// best split of all instances with long double sums: feature and
+// threshold, the largest value in the left side. ties are broken by
+// the smallest feature and the first position, as in the greedy
+static void ref_split( const InstanceSet &iset, const ResultsSet &rset, int minEl,
+                       size_t *bestF, double *bestVal )
+{
+    const size_t nAlgs = rset.algsettings().size();
+    const int nEl = iset.size();
+
+    long double bestCost = numeric_limits< long double >::max();
+    *bestF = numeric_limits< size_t >::max();
+    *bestVal = 0.0;
+    for ( size_t f=0 ; (f<iset.features().size()) ; ++f )
+    {
+        vector< int > ord( nEl );
+        for ( int i=0 ; (i<nEl) ; ++i )
+            ord[i] = i;
+        stable_sort( ord.begin(), ord.end(), [&] ( int i1, int i2 ) {
+            return iset.instance(i1).float_feature(f) < iset.instance(i2).float_feature(f); } );
+
+        vector< long double > sumL( nAlgs, 0.0 ), tot( nAlgs, 0.0 );
+        for ( int i=0 ; (i<nEl) ; ++i )
+            for ( size_t a=0 ; (a<nAlgs) ; ++a )
+                tot[a] += rset.res( ord[i], a );
+
+        for ( int p=1 ; (p<nEl) ; ++p )
+        {
+            for ( size_t a=0 ; (a<nAlgs) ; ++a )
+                sumL[a] += rset.res( ord[p-1], a );
+
+            const double vL = iset.instance(ord[p-1]).float_feature(f);
+            const double vR = iset.instance(ord[p]).float_feature(f);
+            if (p<minEl || nEl-p<minEl || vR-vL<1e-10)
+                continue;
+
+            long double minL = numeric_limits< long double >::max(), minR = minL;
+            for ( size_t a=0 ; (a<nAlgs) ; ++a )
+            {
+                minL = min( minL, sumL[a] );
+                minR = min( minR, tot[a]-sumL[a] );
+            }
+            if (minL+minR<bestCost)
+            {
+                bestCost = minL+minR;
+                *bestF = f;
+                *bestVal = vL;
+            }
+        }
+    }
+}
+
+// split of the root selected by the greedy with implementation name,
+// with the complete scan and with candidate algorithms, compared with
+// the reference split
+static int check_greedy( const char *name, const InstanceSet &iset, const ResultsSet &rset )
+{
+    size_t refF;
+    double refVal;
+    ref_split( iset, rset, Parameters::minElementsBranch, &refF, &refVal );
+
+    int errors = 0;
+    for ( int candAlgs : { 0, 2 } )
+    {
+        Parameters::greedyCandAlgs = candAlgs;
+        Greedy grd( &iset, &rset );
+        Tree *tree = grd.build();
+
+        const Node *root = tree->root();
+        if (root->branchFeature()!=refF || root->branchValue()!=refVal)
+        {
+            fprintf( stderr, "%s: greedy split (candidate algorithms %d) on feature %zu at %g, "
+                "reference on feature %zu at %g\n", name, candAlgs, root->branchFeature(),
+                root->branchValue(), refF, refVal );
+            ++errors;
+        }
+        delete tree;
+    }
+    Parameters::greedyCandAlgs = 0;
+
+    return errors;
+}
+
+int main()
+{
+    const char *names[] = { "scalar", "avx2", "avx512" };
+
+    // greedy fixture: a single branch
+    string featFile, resFile;
+    write_fixture( featFile, resFile );
+    Parameters::maxDepth = 2;
+    Parameters::minElementsBranch = 5;
+    InstanceSet iset( featFile.c_str(), resFile.c_str() );
+    ResultsSet rset( iset, resFile.c_str() );
+    remove( featFile.c_str() );
+    remove( resFile.c_str() );
+
+    int errors = 0;
+    for ( const char *name : names )
+    {
+        if (!split_kernel_select( name ))
+        {
+            printf( "%s: not supported, skipped\n", name );
+            continue;
+        }
+
+        const int e = check( name, 67 ) + check_greedy( name, iset, rset );
+        printf( "%s: %s\n", name, e ? "FAILED" : "ok" );
+        errors += e;
+    }
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}